@@ -2,17 +2,79 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <cstddef>
 #include "Value.hpp"
 #include "Tokenizer.hpp"
 
 class Interpreter;
+class MemoCache;
+class FormatTemplate;
 using AstNodePtr = std::shared_ptr<class AstNode>;
 
+// Bump allocator behind the nodes of one parse. Nodes (with their reference
+// counts) are packed in source order into large blocks instead of scattered
+// across the heap. Nothing is freed until the arena itself is destroyed, so it
+// must outlive every node built in it: the Interpreter keeps the arena of each
+// parse it runs.
+class AstArena {
+public:
+    static const size_t BLOCK_SIZE = 64 * 1024;
+
+    void* allocate(size_t bytes) {
+        const size_t align = alignof(std::max_align_t);
+        bytes = (bytes + align - 1) & ~(align - 1);
+        if (bytes > BLOCK_SIZE) {
+            blocks.emplace_back(new char[bytes]);
+            return blocks.back().get();
+        }
+        if (!current || used + bytes > BLOCK_SIZE) {
+            blocks.emplace_back(new char[BLOCK_SIZE]);
+            current = blocks.back().get();
+            used = 0;
+        }
+        void* p = current + used;
+        used += bytes;
+        return p;
+    }
+
+private:
+    std::vector<std::unique_ptr<char[]>> blocks;
+    char* current = nullptr;
+    size_t used = 0;
+};
+
+// allocate_shared() allocator drawing from an AstArena. It does not own the
+// arena, so control blocks stay one pointer larger than make_shared()'s;
+// individual frees are no-ops.
+template <class T>
+struct ArenaAllocator {
+    using value_type = T;
+    AstArena* arena;
+    explicit ArenaAllocator(AstArena* a) : arena(a) {}
+    template <class U> ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+    T* allocate(size_t n) { return static_cast<T*>(arena->allocate(n * sizeof(T))); }
+    void deallocate(T*, size_t) {}
+    template <class U> bool operator==(const ArenaAllocator<U>& other) const { return arena == other.arena; }
+    template <class U> bool operator!=(const ArenaAllocator<U>& other) const { return arena != other.arena; }
+};
+
+// Function body skipped by a lazy parse: the source between `do` and the
+// matching `end`, parsed into `body` on the first call.
+struct LazyBody {
+    std::string source;
+    int line;
+    bool parsed = false;
+    std::vector<AstNodePtr> body;
+    LazyBody(const std::string& s, int l) : source(s), line(l) {}
+};
+
 struct Function {
     std::string name;
     std::vector<class ParameterDefinition> params;
     std::vector<AstNodePtr> body;
     std::shared_ptr<Environment> closure;
+    std::shared_ptr<MemoCache> memo; // Set by memo(); calls consult it first
+    std::shared_ptr<LazyBody> lazy_body; // Unparsed body, replaces `body` on first call
     Function(const std::string& n, const std::vector<ParameterDefinition>& p,
              const std::vector<AstNodePtr>& b, const std::shared_ptr<Environment>& c)
         : name(n), params(p), body(b), closure(c) {}
@@ -30,20 +92,63 @@ struct ParameterDefinition {
         : type_keyword(tk), name(n), default_value(nullptr), default_expr(de), has_default(true) {}
 };
 
-struct AstNode { int line; AstNode(int l) : line(l) {} virtual ~AstNode() = default; virtual ValuePtr accept(Interpreter& visitor) = 0; };
+struct AstNode {
+    int line;
+    AstNode(int l) : line(l) {}
+    virtual ~AstNode() = default;
+    virtual ValuePtr accept(Interpreter& visitor) = 0;
+    // Evaluates the node for its truthiness only. Conditions override this to
+    // branch on a native bool instead of boxing a NumberValue first.
+    virtual bool test(Interpreter& visitor);
+};
+// Operand kinds observed by a quickened node; NUMBERS sites skip virtual dispatch.
+enum class Quickened : uint8_t { UNSEEN, NUMBERS, GENERIC };
 struct LiteralNode : AstNode { ValuePtr value; LiteralNode(int l, ValuePtr v) : AstNode(l), value(v) {} ValuePtr accept(Interpreter& visitor) override; };
 struct ListLiteralNode : AstNode { std::vector<AstNodePtr> elements; ListLiteralNode(int l, std::vector<AstNodePtr> e) : AstNode(l), elements(e) {} ValuePtr accept(Interpreter& visitor) override; };
+// f"...": the literal segments are compiled once; `args` are the embedded
+// expressions in order.
+struct FormatStringNode : AstNode { std::shared_ptr<const FormatTemplate> format; std::vector<AstNodePtr> args; FormatStringNode(int l, std::shared_ptr<const FormatTemplate> f, std::vector<AstNodePtr> a) : AstNode(l), format(f), args(a) {} ValuePtr accept(Interpreter& visitor) override; };
 struct DimLiteralNode : AstNode { std::vector<std::pair<AstNodePtr, AstNodePtr>> entries; DimLiteralNode(int l, std::vector<std::pair<AstNodePtr, AstNodePtr>> e) : AstNode(l), entries(e) {} ValuePtr accept(Interpreter& visitor) override; };
 struct VariableNode : AstNode { std::string name; VariableNode(int l, std::string n) : AstNode(l), name(n) {} ValuePtr accept(Interpreter& visitor) override; };
-struct UnaryOpNode : AstNode { Token op; AstNodePtr right; UnaryOpNode(int l, Token o, AstNodePtr r) : AstNode(l), op(o), right(r) {} ValuePtr accept(Interpreter& visitor) override; };
-struct BinaryOpNode : AstNode { AstNodePtr left; Token op; AstNodePtr right; BinaryOpNode(int l, AstNodePtr lt, Token o, AstNodePtr rt) : AstNode(l), left(lt), op(o), right(rt) {} ValuePtr accept(Interpreter& visitor) override; };
-struct LogicalOpNode : AstNode { AstNodePtr left; Token op; AstNodePtr right; LogicalOpNode(int l, AstNodePtr lt, Token o, AstNodePtr rt) : AstNode(l), left(lt), op(o), right(rt) {} ValuePtr accept(Interpreter& visitor) override; };
-struct TypeConversionNode : AstNode { AstNodePtr expression; Token type_keyword; TypeConversionNode(int l, AstNodePtr e, Token tk) : AstNode(l), expression(e), type_keyword(tk) {} ValuePtr accept(Interpreter& visitor) override; };
-struct AssignmentNode : AstNode { AstNodePtr target; AstNodePtr value; AssignmentNode(int l, AstNodePtr t, AstNodePtr v) : AstNode(l), target(t), value(v) {} ValuePtr accept(Interpreter& visitor) override; };
-struct VarDeclarationNode : AstNode { Token keyword; std::string name; AstNodePtr initializer; bool is_exposed; VarDeclarationNode(int l, Token kw, std::string n, AstNodePtr init, bool e = false) : AstNode(l), keyword(kw), name(n), initializer(init), is_exposed(e) {} ValuePtr accept(Interpreter& visitor) override; };
+struct UnaryOpNode : AstNode { TokenType op; AstNodePtr right; UnaryOpNode(int l, TokenType o, AstNodePtr r) : AstNode(l), op(o), right(r) {} ValuePtr accept(Interpreter& visitor) override; bool test(Interpreter& visitor) override; };
+struct BinaryOpNode : AstNode {
+    AstNodePtr left; TokenType op; AstNodePtr right;
+    Quickened quickened;
+    BinaryOpNode(int l, AstNodePtr lt, TokenType o, AstNodePtr rt) : AstNode(l), left(lt), op(o), right(rt), quickened(Quickened::UNSEEN) {}
+    ValuePtr accept(Interpreter& visitor) override;
+    bool test(Interpreter& visitor) override;
+    // Applies the operator to already evaluated operands (shared by fused assignments).
+    ValuePtr apply(const ValuePtr& left_val, const ValuePtr& right_val);
+    bool is_comparison() const;
+};
+struct LogicalOpNode : AstNode { AstNodePtr left; TokenType op; AstNodePtr right; LogicalOpNode(int l, AstNodePtr lt, TokenType o, AstNodePtr rt) : AstNode(l), left(lt), op(o), right(rt) {} ValuePtr accept(Interpreter& visitor) override; bool test(Interpreter& visitor) override; };
+struct TypeConversionNode : AstNode { AstNodePtr expression; TokenType type_keyword; TypeConversionNode(int l, AstNodePtr e, TokenType tk) : AstNode(l), expression(e), type_keyword(tk) {} ValuePtr accept(Interpreter& visitor) override; };
+struct AssignmentNode : AstNode {
+    AstNodePtr target; AstNodePtr value;
+    Quickened self_update; // NUMBERS here means the fused `x = x <op> y` form applies
+    AssignmentNode(int l, AstNodePtr t, AstNodePtr v) : AstNode(l), target(t), value(v), self_update(Quickened::UNSEEN) {}
+    ValuePtr accept(Interpreter& visitor) override;
+};
+// `target <op>= value`: the l-value (object and index included) is evaluated
+// once, and a uniquely referenced target value is updated in place.
+struct CompoundAssignmentNode : AstNode {
+    AstNodePtr target;
+    std::shared_ptr<BinaryOpNode> operation; // operation->right is the operand
+    CompoundAssignmentNode(int l, AstNodePtr t, std::shared_ptr<BinaryOpNode> op) : AstNode(l), target(t), operation(op) {}
+    ValuePtr accept(Interpreter& visitor) override;
+};
+struct VarDeclarationNode : AstNode { TokenType keyword; std::string name; AstNodePtr initializer; bool is_exposed; VarDeclarationNode(int l, TokenType kw, std::string n, AstNodePtr init, bool e = false) : AstNode(l), keyword(kw), name(n), initializer(init), is_exposed(e) {} ValuePtr accept(Interpreter& visitor) override; };
 struct UsingNode : AstNode { std::string original_name; std::string alias_name; UsingNode(int l, std::string o, std::string a) : AstNode(l), original_name(o), alias_name(a) {} ValuePtr accept(Interpreter& visitor) override; };
 struct IfStatementNode : AstNode { AstNodePtr condition; std::vector<AstNodePtr> then_branch, else_branch; IfStatementNode(int l, AstNodePtr c, std::vector<AstNodePtr> t, std::vector<AstNodePtr> e) : AstNode(l), condition(c), then_branch(t), else_branch(e) {} ValuePtr accept(Interpreter& visitor) override; };
-struct WhileStatementNode : AstNode { AstNodePtr condition; std::vector<AstNodePtr> do_branch, finally_branch; WhileStatementNode(int l, AstNodePtr c, std::vector<AstNodePtr> d, std::vector<AstNodePtr> f) : AstNode(l), condition(c), do_branch(d), finally_branch(f) {} ValuePtr accept(Interpreter& visitor) override; };
+struct WhileStatementNode : AstNode {
+    AstNodePtr condition; std::vector<AstNodePtr> do_branch, finally_branch;
+    // Set by the Optimizer for `while i <cmp> bound do ... i += step end`:
+    // `counter` is i and `counted_body` is the body without the final step.
+    std::string counter; long long step = 0; std::vector<AstNodePtr> counted_body;
+    WhileStatementNode(int l, AstNodePtr c, std::vector<AstNodePtr> d, std::vector<AstNodePtr> f) : AstNode(l), condition(c), do_branch(d), finally_branch(f) {}
+    ValuePtr accept(Interpreter& visitor) override;
+    bool run_counted(Interpreter& visitor);
+};
 struct LoopForNode : AstNode { std::string index_var_name; std::vector<AstNodePtr> body; AstNodePtr count_expr; LoopForNode(int l, std::string ivn, std::vector<AstNodePtr> b, AstNodePtr c) : AstNode(l), index_var_name(ivn), body(b), count_expr(c) {} ValuePtr accept(Interpreter& visitor) override; };
 struct ForInNode : AstNode { std::string var_name; AstNodePtr iterable; std::vector<AstNodePtr> body; ForInNode(int l, const std::string& vn, AstNodePtr it, const std::vector<AstNodePtr>& b) : AstNode(l), var_name(vn), iterable(it), body(b) {} ValuePtr accept(Interpreter& visitor) override; };
 struct LoopUntilNode : AstNode { std::string index_var_name; std::vector<AstNodePtr> body; AstNodePtr condition; LoopUntilNode(int l, std::string ivn, std::vector<AstNodePtr> b, AstNodePtr c) : AstNode(l), index_var_name(ivn), body(b), condition(c) {} ValuePtr accept(Interpreter& visitor) override; };
@@ -52,12 +157,18 @@ struct ContinueNode : AstNode { ContinueNode(int l) : AstNode(l) {} ValuePtr acc
 struct AwaitStatementNode : AstNode { AstNodePtr condition; std::vector<AstNodePtr> then_branch; AwaitStatementNode(int l, AstNodePtr c, std::vector<AstNodePtr> t) : AstNode(l), condition(c), then_branch(t) {} ValuePtr accept(Interpreter& visitor) override; };
 struct SayNode : AstNode { AstNodePtr expression; SayNode(int l, AstNodePtr e) : AstNode(l), expression(e) {} ValuePtr accept(Interpreter& visitor) override; };
 struct InpNode : AstNode { AstNodePtr expression; InpNode(int l, AstNodePtr e) : AstNode(l), expression(e) {} ValuePtr accept(Interpreter& visitor) override; };
-struct FnDefNode : AstNode { std::string name; std::vector<ParameterDefinition> params; std::vector<AstNodePtr> body; bool is_method; bool is_exposed; FnDefNode(int l, std::string n, std::vector<ParameterDefinition> p, std::vector<AstNodePtr> b, bool m = false, bool e = false) : AstNode(l), name(n), params(p), body(b), is_method(m), is_exposed(e) {} ValuePtr accept(Interpreter& visitor) override; };
+struct FnDefNode : AstNode { std::string name; std::vector<ParameterDefinition> params; std::vector<AstNodePtr> body; std::shared_ptr<LazyBody> lazy_body; bool is_method; bool is_exposed; bool is_memo; FnDefNode(int l, std::string n, std::vector<ParameterDefinition> p, std::vector<AstNodePtr> b, bool m = false, bool e = false, bool memo = false) : AstNode(l), name(n), params(p), body(b), is_method(m), is_exposed(e), is_memo(memo) {} ValuePtr accept(Interpreter& visitor) override; };
 struct CallNode : AstNode { AstNodePtr callee; std::vector<AstNodePtr> arguments; CallNode(int l, AstNodePtr c, std::vector<AstNodePtr> a) : AstNode(l), callee(c), arguments(a) {} ValuePtr accept(Interpreter& visitor) override; };
-struct SubscriptNode : AstNode { AstNodePtr object; AstNodePtr start; AstNodePtr end; AstNodePtr step; bool is_slice; SubscriptNode(int l, AstNodePtr o, AstNodePtr s, AstNodePtr e, AstNodePtr st, bool slice) : AstNode(l), object(o), start(s), end(e), step(st), is_slice(slice) {} ValuePtr accept(Interpreter& visitor) override; };
+struct SubscriptNode : AstNode { AstNodePtr object; AstNodePtr start; AstNodePtr end; AstNodePtr step; bool is_slice; Quickened quickened; SubscriptNode(int l, AstNodePtr o, AstNodePtr s, AstNodePtr e, AstNodePtr st, bool slice) : AstNode(l), object(o), start(s), end(e), step(st), is_slice(slice), quickened(Quickened::UNSEEN) {} ValuePtr accept(Interpreter& visitor) override; };
 struct ReturnNode : AstNode { AstNodePtr value; ReturnNode(int l, AstNodePtr v) : AstNode(l), value(v) {} ValuePtr accept(Interpreter& visitor) override; };
 struct RaiseNode : AstNode { AstNodePtr expression; RaiseNode(int l, AstNodePtr e) : AstNode(l), expression(e) {} ValuePtr accept(Interpreter& visitor) override; };
-struct TryCatchNode : AstNode { std::vector<AstNodePtr> try_branch; std::string exception_var; std::vector<AstNodePtr> catch_branch; std::vector<AstNodePtr> finally_branch; TryCatchNode(int l, std::vector<AstNodePtr> t, std::string ev, std::vector<AstNodePtr> c, std::vector<AstNodePtr> f) : AstNode(l), try_branch(t), exception_var(ev), catch_branch(c), finally_branch(f) {} ValuePtr accept(Interpreter& visitor) override; };
+struct TryCatchNode : AstNode {
+    std::vector<AstNodePtr> try_branch; std::string exception_var; std::vector<AstNodePtr> catch_branch; std::vector<AstNodePtr> finally_branch;
+    // Set by the parser: a block that declares no names runs in the enclosing scope.
+    bool try_scoped, finally_scoped;
+    TryCatchNode(int l, std::vector<AstNodePtr> t, std::string ev, std::vector<AstNodePtr> c, std::vector<AstNodePtr> f) : AstNode(l), try_branch(t), exception_var(ev), catch_branch(c), finally_branch(f), try_scoped(true), finally_scoped(true) {}
+    ValuePtr accept(Interpreter& visitor) override;
+};
 struct ClassDefNode : AstNode {
     std::string name;
     std::vector<ParameterDefinition> fields;
@@ -110,3 +221,21 @@ struct ExpressionStatementNode : AstNode {
     ExpressionStatementNode(int l, AstNodePtr e) : AstNode(l), expression(e) {}
     ValuePtr accept(Interpreter& visitor) override;
 };
+// Parameter of an inlined function body, read from the arguments the
+// enclosing InlinedCallNode evaluated (Interpreter::inline_args).
+struct InlineArgNode : AstNode {
+    size_t index;
+    InlineArgNode(int l, size_t i) : AstNode(l), index(i) {}
+    ValuePtr accept(Interpreter& visitor) override;
+};
+// Call site the Optimizer inlined a small function into. When the callee at
+// run time is not a function built from the inlined definition, the original
+// call runs instead.
+struct InlinedCallNode : AstNode {
+    static const size_t MAX_ARGS = 4;
+    std::shared_ptr<CallNode> call;
+    AstNodePtr origin; // Sole body statement of the inlined definition
+    AstNodePtr body;   // Its return expression, parameters replaced by InlineArgNodes
+    InlinedCallNode(int l, std::shared_ptr<CallNode> c, AstNodePtr o, AstNodePtr b) : AstNode(l), call(c), origin(o), body(b) {}
+    ValuePtr accept(Interpreter& visitor) override;
+};
@@ -25,7 +25,9 @@ namespace BigNumberDetail {
 
     const int BASE = 5;       // Each digit in UnsignedDigit stores up to 5 decimal digits
     const int MOD = 100000; // The base for our big number representation (10^BASE)
+    const int POW10[BASE] = {1, 10, 100, 1000, 10000};
     const int LGM = 17;
+    const long long SCHOOL_DIV_LIMIT = 1 << 17; // Limb products up to which long division beats Newton
     const double PI = 3.1415926535897932384626;
 
     class UnsignedDigit;
@@ -63,11 +65,26 @@ namespace BigNumberDetail {
         UnsignedDigit operator-(const UnsignedDigit& rhs) const;
         UnsignedDigit operator*(const UnsignedDigit& rhs) const;
         UnsignedDigit operator/(const UnsignedDigit& rhs) const;
-        UnsignedDigit operator/(int v) const;
+        UnsignedDigit operator/(ll v) const;
+        UnsignedDigit operator%(const UnsignedDigit& rhs) const;
+
+        // Quotient and remainder together: schoolbook long division (Knuth's
+        // algorithm D) while the operands are short, Newton reciprocal otherwise.
+        void divmod(const UnsignedDigit& rhs, UnsignedDigit& quot, UnsignedDigit& rem) const;
 
         // Equivalent to multiplication by MOD^k
         UnsignedDigit move(int k) const;
 
+        // In-place kernels. They reuse the existing limb storage and only grow it
+        // when the result needs more limbs.
+        void add_in_place(const UnsignedDigit& rhs);
+        void sub_in_place(const UnsignedDigit& rhs);  // *this -= rhs, requires rhs <= *this
+        void rsub_in_place(const UnsignedDigit& lhs); // *this = lhs - *this, requires *this <= lhs
+        void mul_small_in_place(ll k);                // k < MOD^2
+        void fma_small_in_place(const UnsignedDigit& rhs, ll k, int shift = 0); // *this += rhs * k * MOD^shift
+        void scale10_in_place(int k);                 // *this *= 10^k, k >= 0
+        ll div_small_in_place(ll k);                  // *this /= k, returns the remainder; k < 2^40
+
         friend UnsignedDigit DivHelper::quasiInv(const UnsignedDigit& v);
         friend void swap(UnsignedDigit& lhs, UnsignedDigit& rhs) { std::swap(lhs.digits, rhs.digits); }
 
@@ -80,25 +97,34 @@ namespace BigNumberDetail {
         inline void fft(cd* a, int lgn, int d) {
             int n = 1 << lgn;
             static std::vector<int> brev;
+            static std::vector<cd> roots; // roots[i] = e^(2*pi*i*k/R) for the largest size R seen
             if (n != (int)brev.size()) {
                 brev.resize(n);
                 for (int i = 0; i < n; ++i)
                     brev[i] = (brev[i >> 1] >> 1) | ((i & 1) << (lgn - 1));
             }
+            if (n > 2 * (int)roots.size()) {
+                // Twiddles come straight from cos/sin; accumulating w *= omega
+                // loses precision long before the products stop fitting a double.
+                roots.resize(n / 2);
+                for (int i = 0; i < n / 2; ++i)
+                    roots[i] = cd(cos(2 * PI * i / n), sin(2 * PI * i / n));
+            }
+            int r_size = 2 * roots.size();
             for (int i = 0; i < n; ++i)
                 if (brev[i] < i)
                     std::swap(a[brev[i]], a[i]);
             
             for (int t = 1; t < n; t <<= 1) {
-                cd omega(cos(PI / t), sin(PI * d / t));
+                int step = r_size / (t << 1);
                 for (int i = 0; i < n; i += t << 1) {
                     cd* p = a + i;
-                    cd w(1);
                     for (int j = 0; j < t; ++j) {
+                        cd w = roots[j * step];
+                        if (d == -1) w = std::conj(w);
                         cd x = p[j + t] * w;
                         p[j + t] = p[j] - x;
                         p[j] += x;
-                        w *= omega;
                     }
                 }
             }
@@ -108,6 +134,11 @@ namespace BigNumberDetail {
             }
         }
 
+        // Above this transform size full 10^5 limbs would overflow the 53-bit
+        // mantissa, so each limb is split as lo + hi * SPLIT before transforming.
+        const int SPLIT_LGN = 12;
+        const int SPLIT = 1000;
+
         inline std::vector<ll> conv(const std::vector<int>& a, const std::vector<int>& b) {
             int n = a.size() - 1, m = b.size() - 1;
             if (n < 1000 / (m + 1) || n < 10 || m < 10) {
@@ -120,17 +151,41 @@ namespace BigNumberDetail {
             int lgn = 0;
             while ((1 << lgn) <= n + m)
                 ++lgn;
-            std::vector<cd> ta(a.begin(), a.end()), tb(b.begin(), b.end());
-            ta.resize(1 << lgn);
-            tb.resize(1 << lgn);
+            int size = 1 << lgn;
+            std::vector<ll> ret(n + m + 1);
+            if (lgn <= SPLIT_LGN) {
+                std::vector<cd> ta(a.begin(), a.end()), tb(b.begin(), b.end());
+                ta.resize(size);
+                tb.resize(size);
+                fft(ta.data(), lgn, 1);
+                fft(tb.data(), lgn, 1);
+                for (int i = 0; i < size; ++i)
+                    ta[i] *= tb[i];
+                fft(ta.data(), lgn, -1);
+                for (int i = 0; i <= n + m; ++i)
+                    ret[i] = ta[i].real() + 0.5;
+                return ret;
+            }
+            // Both halves of an operand share one transform (lo + i*hi) and are
+            // separated again through conjugate symmetry.
+            std::vector<cd> ta(size), tb(size), lo(size), mid(size);
+            for (int i = 0; i <= n; ++i) ta[i] = cd(a[i] % SPLIT, a[i] / SPLIT);
+            for (int i = 0; i <= m; ++i) tb[i] = cd(b[i] % SPLIT, b[i] / SPLIT);
             fft(ta.data(), lgn, 1);
             fft(tb.data(), lgn, 1);
-            for (int i = 0; i < (1 << lgn); ++i)
-                ta[i] *= tb[i];
-            fft(ta.data(), lgn, -1);
-            std::vector<ll> ret(n + m + 1);
-            for (int i = 0; i <= n + m; ++i)
-                ret[i] = ta[i].real() + 0.5;
+            for (int i = 0; i < size; ++i) {
+                int j = (size - i) & (size - 1);
+                cd a_lo = (ta[i] + std::conj(ta[j])) * 0.5, a_hi = (ta[i] - std::conj(ta[j])) * cd(0, -0.5);
+                cd b_lo = (tb[i] + std::conj(tb[j])) * 0.5, b_hi = (tb[i] - std::conj(tb[j])) * cd(0, -0.5);
+                lo[i] = a_lo * b_lo + cd(0, 1) * (a_hi * b_hi);
+                mid[i] = a_lo * b_hi + a_hi * b_lo;
+            }
+            fft(lo.data(), lgn, -1);
+            fft(mid.data(), lgn, -1);
+            for (int i = 0; i <= n + m; ++i) {
+                ll low = std::llround(lo[i].real()), high = std::llround(lo[i].imag()), middle = std::llround(mid[i].real());
+                ret[i] = low + middle * SPLIT + high * (ll)SPLIT * SPLIT;
+            }
             return ret;
         }
 
@@ -146,27 +201,34 @@ namespace BigNumberDetail {
                 return tmp / v.digits[0];
             }
             if (v.digits.size() == 2) {
-                UnsignedDigit sum = 0, go = 1;
-                std::vector<int> tmp(4);
-                go = go.move(4);
-                std::vector<UnsignedDigit> db(LGM);
-                db[0] = v;
-                for (int i = 1; i < LGM; ++i)
-                    db[i] = db[i - 1] + db[i - 1];
-                for (int i = 3; i >= 0; --i) {
-                    for (int k = LGM - 1; k >= 0; --k)
-                        if (sum + db[k].move(i) <= go) {
-                            sum = sum + db[k].move(i);
-                            tmp[i] |= 1 << k;
-                        }
-                }
-                return tmp;
+                // floor(MOD^4 / v) by exact short division; v < MOD^2 fits in a long long.
+                UnsignedDigit tmp;
+                tmp.digits.assign(5, 0);
+                tmp.digits[4] = 1;
+                return tmp / (v.digits[1] * (ll)MOD + v.digits[0]);
             }
             int n = v.digits.size(), k = (n + 2) / 2;
             UnsignedDigit tmp = quasiInv(std::vector<int>(v.digits.data() + n - k, v.digits.data() + n));
             return (UnsignedDigit(2) * tmp).move(n - k) - (v * tmp * tmp).move(-2 * k);
         }
 
+        // a / b given inv = quasiInv(b * MOD^t). The reciprocal may be off by one in
+        // either direction, so the quotient is fixed up against the remainder.
+        inline void divmod_by_inverse(const UnsignedDigit& a, const UnsignedDigit& b, const UnsignedDigit& inv, int t,
+                                      UnsignedDigit& quot, UnsignedDigit& rem) {
+            quot = (a.move(t) * inv).move(-2 * (b.size() + t));
+            UnsignedDigit prod = quot * b;
+            while (a < prod) {
+                quot = quot - 1;
+                prod = prod - b;
+            }
+            rem = a - prod;
+            while (b <= rem) {
+                quot = quot + 1;
+                rem = rem - b;
+            }
+        }
+
     } // namespace DivHelper
 
     inline UnsignedDigit::UnsignedDigit(ll x) {
@@ -195,6 +257,109 @@ namespace BigNumberDetail {
         return ret;
     }
 
+    inline void UnsignedDigit::add_in_place(const UnsignedDigit& rhs) {
+        size_t n = rhs.digits.size();
+        if (digits.size() < n) digits.resize(n, 0);
+        int carry = 0;
+        for (size_t i = 0; i < n; ++i) {
+            int t = digits[i] + rhs.digits[i] + carry;
+            carry = t >= MOD;
+            digits[i] = t - carry * MOD;
+        }
+        for (size_t i = n; carry && i < digits.size(); ++i) {
+            if (++digits[i] == MOD) digits[i] = 0;
+            else carry = 0;
+        }
+        if (carry) digits.push_back(1);
+    }
+
+    inline void UnsignedDigit::sub_in_place(const UnsignedDigit& rhs) {
+        size_t n = rhs.digits.size();
+        int borrow = 0;
+        for (size_t i = 0; i < n; ++i) {
+            int t = digits[i] - rhs.digits[i] - borrow;
+            borrow = t < 0;
+            digits[i] = t + borrow * MOD;
+        }
+        for (size_t i = n; borrow && i < digits.size(); ++i) {
+            if (--digits[i] < 0) digits[i] += MOD;
+            else borrow = 0;
+        }
+        trim();
+    }
+
+    inline void UnsignedDigit::rsub_in_place(const UnsignedDigit& lhs) {
+        size_t n = lhs.digits.size();
+        digits.resize(n, 0);
+        int borrow = 0;
+        for (size_t i = 0; i < n; ++i) {
+            int t = lhs.digits[i] - digits[i] - borrow;
+            borrow = t < 0;
+            digits[i] = t + borrow * MOD;
+        }
+        trim();
+    }
+
+    inline void UnsignedDigit::mul_small_in_place(ll k) {
+        if (k == 0 || isZero()) {
+            digits.assign(1, 0);
+            return;
+        }
+        ll carry = 0;
+        for (size_t i = 0; i < digits.size(); ++i) {
+            carry += digits[i] * k;
+            digits[i] = carry % MOD;
+            carry /= MOD;
+        }
+        while (carry) {
+            digits.push_back(carry % MOD);
+            carry /= MOD;
+        }
+    }
+
+    inline void UnsignedDigit::fma_small_in_place(const UnsignedDigit& rhs, ll k, int shift) {
+        if (k == 0 || rhs.isZero()) return;
+        if (&rhs == this) {
+            UnsignedDigit copy(rhs);
+            fma_small_in_place(copy, k, shift);
+            return;
+        }
+        size_t n = rhs.digits.size() + shift;
+        if (digits.size() < n) digits.resize(n, 0);
+        ll carry = 0;
+        for (size_t i = shift; i < n; ++i) {
+            carry += digits[i] + rhs.digits[i - shift] * k;
+            digits[i] = carry % MOD;
+            carry /= MOD;
+        }
+        for (size_t i = n; carry && i < digits.size(); ++i) {
+            carry += digits[i];
+            digits[i] = carry % MOD;
+            carry /= MOD;
+        }
+        while (carry) {
+            digits.push_back(carry % MOD);
+            carry /= MOD;
+        }
+    }
+
+    inline void UnsignedDigit::scale10_in_place(int k) {
+        if (k == 0 || isZero()) return;
+        if (k % BASE) mul_small_in_place(POW10[k % BASE]);
+        if (k / BASE) digits.insert(digits.begin(), k / BASE, 0);
+    }
+
+    inline ll UnsignedDigit::div_small_in_place(ll k) {
+        ll r = 0;
+        for (int i = (int)digits.size() - 1; i >= 0; --i) {
+            r = r * MOD + digits[i];
+            digits[i] = r / k;
+            r %= k;
+        }
+        trim();
+        return r;
+    }
+
     inline bool UnsignedDigit::operator<(const UnsignedDigit& rhs) const {
         int n = digits.size(), m = rhs.digits.size();
         if (n != m) return n < m;
@@ -275,19 +440,102 @@ namespace BigNumberDetail {
     }
 
     inline UnsignedDigit UnsignedDigit::operator/(const UnsignedDigit& rhs) const {
-        int m = digits.size(), n = rhs.digits.size(), t = 0;
-        if (m < n) return 0;
-        if (m > n * 2) t = m - 2 * n;
-        UnsignedDigit sv = DivHelper::quasiInv(rhs.move(t));
-        UnsignedDigit ret = move(t) * sv;
-        ret = ret.move(-2 * (n + t));
-        if ((ret + 1) * rhs <= *this) {
-             ret = ret + 1;
+        UnsignedDigit quot, rem;
+        divmod(rhs, quot, rem);
+        return quot;
+    }
+
+    inline UnsignedDigit UnsignedDigit::operator%(const UnsignedDigit& rhs) const {
+        UnsignedDigit quot, rem;
+        divmod(rhs, quot, rem);
+        return rem;
+    }
+
+    inline void UnsignedDigit::divmod(const UnsignedDigit& rhs, UnsignedDigit& quot, UnsignedDigit& rem) const {
+        int m = digits.size(), n = rhs.digits.size();
+        if (*this < rhs) {
+            quot = 0;
+            rem = *this;
+            return;
         }
-        return ret;
+        if (n == 1) {
+            ll r = 0, k = rhs.digits[0];
+            std::vector<int> q(m);
+            for (int i = m - 1; i >= 0; --i) {
+                r = r * MOD + digits[i];
+                q[i] = r / k;
+                r %= k;
+            }
+            quot = q;
+            rem = r;
+            return;
+        }
+        if ((ll)n * (m - n + 1) > SCHOOL_DIV_LIMIT) {
+            int t = (m > n * 2) ? m - 2 * n : 0;
+            DivHelper::divmod_by_inverse(*this, rhs, DivHelper::quasiInv(rhs.move(t)), t, quot, rem);
+            return;
+        }
+        // Scale so the divisor's top limb is at least MOD/2; then the two-limb
+        // trial quotient is at most two too large and the first check fixes one.
+        ll d = MOD / (rhs.digits.back() + 1);
+        std::vector<ll> u(m + 1), v(n);
+        ll carry = 0;
+        for (int i = 0; i < m; ++i) {
+            carry += digits[i] * d;
+            u[i] = carry % MOD;
+            carry /= MOD;
+        }
+        u[m] = carry;
+        carry = 0;
+        for (int i = 0; i < n; ++i) {
+            carry += rhs.digits[i] * d;
+            v[i] = carry % MOD;
+            carry /= MOD;
+        }
+        std::vector<int> q(m - n + 1);
+        for (int j = m - n; j >= 0; --j) {
+            ll num = u[j + n] * MOD + u[j + n - 1];
+            ll qhat = num / v[n - 1], rhat = num % v[n - 1];
+            while (qhat >= MOD || qhat * v[n - 2] > rhat * MOD + u[j + n - 2]) {
+                --qhat;
+                rhat += v[n - 1];
+                if (rhat >= MOD) break;
+            }
+            ll borrow = 0;
+            carry = 0;
+            for (int i = 0; i < n; ++i) {
+                ll p = qhat * v[i] + carry;
+                carry = p / MOD;
+                ll t = u[i + j] - p % MOD - borrow;
+                borrow = t < 0;
+                u[i + j] = t + borrow * MOD;
+            }
+            u[j + n] -= carry + borrow;
+            if (u[j + n] < 0) {
+                // The trial quotient was still one too large: add the divisor back.
+                --qhat;
+                carry = 0;
+                for (int i = 0; i < n; ++i) {
+                    ll t = u[i + j] + v[i] + carry;
+                    carry = t >= MOD;
+                    u[i + j] = t - carry * MOD;
+                }
+                u[j + n] += carry;
+            }
+            q[j] = qhat;
+        }
+        quot = q;
+        std::vector<int> r(n);
+        ll rest = 0;
+        for (int i = n - 1; i >= 0; --i) {
+            rest = rest * MOD + u[i];
+            r[i] = rest / d;
+            rest %= d;
+        }
+        rem = r;
     }
 
-    inline UnsignedDigit UnsignedDigit::operator/(int k) const {
+    inline UnsignedDigit UnsignedDigit::operator/(ll k) const {
         UnsignedDigit ret;
         int n = digits.size();
         ret.digits.resize(n);
@@ -347,6 +595,240 @@ namespace BigNumberDetail {
         return ret;
     }
 
+    namespace RootHelper { // Integer roots by Newton iteration with precision doubling
+
+        // Approximates v / MOD^shift from the leading limbs of v.
+        inline double leading(const UnsignedDigit& v, int shift) {
+            int n = v.size(), low = std::max(0, n - 3);
+            double lead = 0;
+            for (int i = n - 1; i >= low; --i) lead = lead * MOD + v.digits[i];
+            return lead * std::pow((double)MOD, low - shift);
+        }
+
+        // Y ~ MOD^p / sqrt(v / MOD^(2h)). Each step doubles the number of correct
+        // limbs and only works at that precision: y += y * (1 - v*y^2) / 2.
+        inline UnsignedDigit rsqrt(const UnsignedDigit& v, int h, int p) {
+            int s = 2;
+            UnsignedDigit y((ll)(MOD * (double)MOD / std::sqrt(leading(v, 2 * h))));
+            while (s < p) {
+                int t = std::min(2 * s - 1, p);
+                UnsignedDigit vy2 = (v.move(t - 2 * h) * (y * y)).move(-2 * s);
+                UnsignedDigit one = UnsignedDigit(1).move(t);
+                UnsignedDigit base = y.move(t - s);
+                if (vy2 <= one) y = base + (y * (one - vy2)).move(-s) / 2;
+                else y = base - (y * (vy2 - one)).move(-s) / 2;
+                s = t;
+            }
+            return y;
+        }
+
+        // floor(sqrt(v)) as v * rsqrt(v), then corrected by at most a few units.
+        inline UnsignedDigit isqrt(const UnsignedDigit& v) {
+            int n = v.size();
+            UnsignedDigit x;
+            if (n <= 3) {
+                x = UnsignedDigit((ll)std::sqrt(leading(v, 0)));
+            } else {
+                int h = (n - 1) / 2, p = h + 3;
+                x = (v * rsqrt(v, h, p)).move(-(p + h));
+            }
+            UnsignedDigit sq = x * x;
+            while (v < sq) {
+                sq = sq + 1 - (x + x);
+                x = x - 1;
+            }
+            for (UnsignedDigit next = sq + x + x + 1; next <= v; next = sq + x + x + 1) {
+                sq = next;
+                x = x + 1;
+            }
+            return x;
+        }
+
+        // floor(v^(1/m)). The root of v's top half is computed recursively; one
+        // more than it, scaled back up, is above the true root, so Newton from
+        // there descends to the floor root in a couple of full-precision steps.
+        inline UnsignedDigit iroot(const UnsignedDigit& v, ll m) {
+            if (m == 1 || v.isZero()) return v;
+            if (m == 2) return isqrt(v);
+            int k = v.size() / (2 * m);
+            UnsignedDigit x;
+            if (k > 0) {
+                x = (iroot(v.move(-m * k), m) + 1).move(k);
+            } else {
+                // The root is below MOD^2, so a double estimate is close enough.
+                double lg = std::log10(leading(v, 0));
+                x = UnsignedDigit((ll)(std::pow(10.0, lg / m) * (1 + 1e-9)) + 1);
+                while (pow(x, m) <= v) x = x + x;
+            }
+            UnsignedDigit xx = (x * (m - 1) + v / pow(x, m - 1)) / m;
+            while (xx < x) {
+                swap(x, xx);
+                xx = (x * (m - 1) + v / pow(x, m - 1)) / m;
+            }
+            return x;
+        }
+
+    } // namespace RootHelper
+
+    namespace RadixHelper { // Divide-and-conquer conversion between base 256 and base MOD
+
+        const int LEAF_BYTES = 16; // Chunks this small are converted digit by digit
+
+        // powers[j] = 256^(LEAF_BYTES * 2^j), grown by squaring and kept for later calls.
+        inline const UnsignedDigit& chunk_power(int j) {
+            static std::vector<UnsignedDigit> powers;
+            if (powers.empty()) {
+                UnsignedDigit p(1);
+                for (int i = 0; i < LEAF_BYTES; ++i) p.mul_small_in_place(256);
+                powers.push_back(p);
+            }
+            while ((int)powers.size() <= j) powers.push_back(powers.back() * powers.back());
+            return powers[j];
+        }
+
+        // Big-endian bytes to a number: the high and low halves are converted
+        // separately and joined with one multiplication by a cached power.
+        inline UnsignedDigit from_bytes(const uint8_t* data, size_t n) {
+            if (n <= (size_t)2 * LEAF_BYTES) {
+                UnsignedDigit acc;
+                for (size_t i = 0; i < n; ++i) {
+                    acc.mul_small_in_place(256);
+                    acc.add_in_place(UnsignedDigit((ll)data[i]));
+                }
+                return acc;
+            }
+            int j = 0;
+            while ((size_t)LEAF_BYTES << (j + 1) < n) ++j;
+            size_t k = (size_t)LEAF_BYTES << j;
+            UnsignedDigit ret = from_bytes(data, n - k) * chunk_power(j);
+            ret.add_in_place(from_bytes(data + n - k, k));
+            ret.trim();
+            return ret;
+        }
+
+        // Every split at level j divides by the same power, so its reciprocal is cached too.
+        inline const UnsignedDigit& chunk_inverse(int j) {
+            static std::vector<UnsignedDigit> inverses;
+            while ((int)inverses.size() <= j) inverses.push_back(DivHelper::quasiInv(chunk_power(inverses.size())));
+            return inverses[j];
+        }
+
+        // Writes v < 256^(LEAF_BYTES * 2^m) as exactly LEAF_BYTES * 2^m bytes.
+        inline void emit_bytes(UnsignedDigit v, int m, uint8_t* out) {
+            size_t n = (size_t)LEAF_BYTES << m;
+            if (m == 0) {
+                for (size_t i = n; i > 0; i -= 4) {
+                    ll r = v.div_small_in_place(1LL << 32);
+                    for (int b = 1; b <= 4; ++b, r >>= 8) out[i - b] = (uint8_t)(r & 0xFF);
+                }
+                return;
+            }
+            UnsignedDigit q, r;
+            const UnsignedDigit& d = chunk_power(m - 1);
+            if ((ll)d.size() * (v.size() - d.size() + 1) <= SCHOOL_DIV_LIMIT) v.divmod(d, q, r);
+            else DivHelper::divmod_by_inverse(v, d, chunk_inverse(m - 1), 0, q, r);
+            emit_bytes(q, m - 1, out);
+            emit_bytes(r, m - 1, out + n / 2);
+        }
+
+        inline std::vector<uint8_t> to_bytes(const UnsignedDigit& v) {
+            int m = 0;
+            while (!(v < chunk_power(m))) ++m;
+            std::vector<uint8_t> out((size_t)LEAF_BYTES << m);
+            emit_bytes(v, m, out.data());
+            size_t lead = 0;
+            while (lead + 1 < out.size() && out[lead] == 0) ++lead;
+            out.erase(out.begin(), out.begin() + lead);
+            return out;
+        }
+
+    } // namespace RadixHelper
+
+    namespace CombHelper { // Integer range products and Fibonacci numbers
+        const ll LEAF_RANGE = 32;
+
+        // lo * (lo + 1) * ... * (hi - 1). Halves are multiplied together so the
+        // FFT multiplier sees operands of similar size; leaves pack as many
+        // factors as fit below MOD^2 into each single-limb multiplication.
+        inline UnsignedDigit range_product(ll lo, ll hi) {
+            if (hi - lo <= LEAF_RANGE) {
+                const ll LIMIT = (ll)MOD * MOD;
+                UnsignedDigit acc(1);
+                ll chunk = 1;
+                for (ll i = lo; i < hi; ++i) {
+                    if (i >= LIMIT) { acc = acc * UnsignedDigit(i); continue; }
+                    if (chunk > (LIMIT - 1) / i) { acc.mul_small_in_place(chunk); chunk = 1; }
+                    chunk *= i;
+                }
+                acc.mul_small_in_place(chunk);
+                return acc;
+            }
+            ll mid = lo + (hi - lo) / 2;
+            return range_product(lo, mid) * range_product(mid, hi);
+        }
+
+        // Fast doubling: f = F(n), g = F(n + 1).
+        inline void fibonacci(ll n, UnsignedDigit& f, UnsignedDigit& g) {
+            if (n == 0) { f = UnsignedDigit(); g = UnsignedDigit(1); return; }
+            UnsignedDigit a, b;
+            fibonacci(n / 2, a, b);
+            UnsignedDigit even = a * (b + b - a); // F(2k)
+            UnsignedDigit odd = a * a + b * b;    // F(2k + 1)
+            if (n % 2) { g = even + odd; f = std::move(odd); }
+            else { f = std::move(even); g = std::move(odd); }
+        }
+    } // namespace CombHelper
+
+    // Carry-save accumulator for long sums. Limbs are added without carrying;
+    // a carry pass only runs when the next addition could overflow, and once
+    // more in result().
+    class WideAccumulator {
+    public:
+        static const ll LIMIT = 4000000000000000000LL;
+
+        // Adds src[i] * scale at limb i + shift, where every src[i] <= bound.
+        void add(const ll* src, size_t n, ll scale, size_t shift, ll bound) {
+            ll step = bound * scale;
+            if (step > LIMIT - top) carry();
+            if (limbs.size() < n + shift) limbs.resize(n + shift, 0);
+            ll* dst = limbs.data() + shift;
+            if (scale == 1) for (size_t i = 0; i < n; ++i) dst[i] += src[i];
+            else for (size_t i = 0; i < n; ++i) dst[i] += src[i] * scale;
+            top += step;
+        }
+        void add(const UnsignedDigit& v, ll scale, size_t shift) {
+            if (limbs.size() < v.size() + shift) limbs.resize(v.size() + shift, 0);
+            if (MOD * scale > LIMIT - top) carry();
+            ll* dst = limbs.data() + shift;
+            for (int i = 0; i < v.size(); ++i) dst[i] += (ll)v.digits[i] * scale;
+            top += MOD * scale;
+        }
+
+        UnsignedDigit result() {
+            carry();
+            UnsignedDigit ret;
+            ret.digits.assign(limbs.begin(), limbs.end());
+            ret.trim();
+            if (ret.digits.empty()) ret.digits.assign(1, 0);
+            return ret;
+        }
+
+    private:
+        std::vector<ll> limbs;
+        ll top = 0; // Upper bound on any limb
+
+        void carry() {
+            ll c = 0;
+            for (size_t i = 0; i < limbs.size(); ++i) {
+                ll v = limbs[i] + c;
+                limbs[i] = v % MOD;
+                c = v / MOD;
+            }
+            while (c) { limbs.push_back(c % MOD); c /= MOD; }
+            top = MOD;
+        }
+    };
+
 } // namespace BigNumberDetail
 
 // =================================================================================
@@ -355,6 +837,7 @@ namespace BigNumberDetail {
 
 
 class BigNumber {
+    friend class Rational;
 private:
     BigNumberDetail::UnsignedDigit magnitude;
     bool is_negative;
@@ -384,21 +867,60 @@ private:
             return this_int_len > other_int_len ? 1 : -1;
         }
 
-        BigNumberDetail::UnsignedDigit a_mag = this->magnitude;
-        BigNumberDetail::UnsignedDigit b_mag = other.magnitude;
-        
         int diff = this->decimal_pos - other.decimal_pos;
-        if (diff > 0) {
-            b_mag = b_mag * BigNumberDetail::pow(BigNumberDetail::UnsignedDigit(10), diff);
-        } else if (diff < 0) {
-            a_mag = a_mag * BigNumberDetail::pow(BigNumberDetail::UnsignedDigit(10), -diff);
-        }
+        if (diff == 0) return compare_mag(this->magnitude, other.magnitude);
+        if (diff > 0) return compare_mag(this->magnitude, other.scaled_magnitude(this->decimal_pos));
+        return compare_mag(this->scaled_magnitude(other.decimal_pos), other.magnitude);
+    }
 
-        if (a_mag < b_mag) return -1;
-        if (b_mag < a_mag) return 1;
+    static int compare_mag(const BigNumberDetail::UnsignedDigit& a, const BigNumberDetail::UnsignedDigit& b) {
+        if (a < b) return -1;
+        if (b < a) return 1;
         return 0;
     }
 
+    // Magnitude rescaled to `dec` fractional digits (dec >= decimal_pos).
+    BigNumberDetail::UnsignedDigit scaled_magnitude(int dec) const {
+        BigNumberDetail::UnsignedDigit ret = magnitude;
+        ret.scale10_in_place(dec - decimal_pos);
+        return ret;
+    }
+
+    // *this += |other| with the given sign. `other` is only copied when it
+    // has to be rescaled for a subtraction; additions fold the rescaling in.
+    void add_signed(const BigNumber& other, bool negative) {
+        if (other.magnitude.isZero()) return;
+        if (&other == this) {
+            BigNumber copy(other);
+            add_signed(copy, negative);
+            return;
+        }
+        if (decimal_pos < other.decimal_pos) {
+            magnitude.scale10_in_place(other.decimal_pos - decimal_pos);
+            decimal_pos = other.decimal_pos;
+        }
+        int shift = decimal_pos - other.decimal_pos;
+        if (magnitude.isZero()) is_negative = negative;
+        if (is_negative == negative) {
+            if (shift == 0) magnitude.add_in_place(other.magnitude);
+            else magnitude.fma_small_in_place(other.magnitude, BigNumberDetail::POW10[shift % BigNumberDetail::BASE], shift / BigNumberDetail::BASE);
+        } else if (shift == 0) {
+            subtract_magnitude(other.magnitude);
+        } else {
+            subtract_magnitude(other.scaled_magnitude(decimal_pos));
+        }
+        normalize();
+    }
+
+    void subtract_magnitude(const BigNumberDetail::UnsignedDigit& b) {
+        if (b <= magnitude) {
+            magnitude.sub_in_place(b);
+        } else {
+            magnitude.rsub_in_place(b);
+            is_negative = !is_negative;
+        }
+    }
+
 public:
     // 1. Construction & Assignment
 
@@ -428,60 +950,35 @@ public:
         normalize();
     }
     // Internal constructor for performance
-    BigNumber(BigNumberDetail::UnsignedDigit mag, bool neg, int dec_pos) : magnitude(mag), is_negative(neg), decimal_pos(dec_pos) { normalize(); }
-
-    BigNumber& operator+=(const BigNumber& other) { *this = *this + other; return *this; }
-    BigNumber& operator-=(const BigNumber& other) { *this = *this - other; return *this; }
-    BigNumber& operator*=(const BigNumber& other) { *this = *this * other; return *this; }
+    BigNumber(BigNumberDetail::UnsignedDigit mag, bool neg, int dec_pos) : magnitude(std::move(mag)), is_negative(neg), decimal_pos(dec_pos) { normalize(); }
+
+    BigNumber& operator+=(const BigNumber& other) { add_signed(other, other.is_negative); return *this; }
+    BigNumber& operator-=(const BigNumber& other) { add_signed(other, !other.is_negative); return *this; }
+    BigNumber& operator*=(const BigNumber& other) {
+        if (other.magnitude.size() == 1) {
+            magnitude.mul_small_in_place(other.magnitude.digits[0]);
+            is_negative = is_negative != other.is_negative;
+            decimal_pos += other.decimal_pos;
+            normalize();
+        } else {
+            *this = *this * other;
+        }
+        return *this;
+    }
     BigNumber& operator/=(const BigNumber& other) { *this = *this / other; return *this; }
 
     // 2. Basic Arithmetic Operations
+    // The && overloads reuse a temporary left operand instead of copying it.
 
-    BigNumber operator+(const BigNumber& other) const {
-        if (this->is_negative == other.is_negative) {
-            int max_dec = std::max(this->decimal_pos, other.decimal_pos);
-            BigNumberDetail::UnsignedDigit a = this->magnitude;
-            BigNumberDetail::UnsignedDigit b = other.magnitude;
-            
-            int a_shift = max_dec - this->decimal_pos;
-            int b_shift = max_dec - other.decimal_pos;
-            if (a_shift > 0) {
-                a = a * BigNumberDetail::pow(BigNumberDetail::UnsignedDigit(10), a_shift);
-            }
-            if (b_shift > 0) {
-                b = b * BigNumberDetail::pow(BigNumberDetail::UnsignedDigit(10), b_shift);
-            }
-
-            return BigNumber(a + b, this->is_negative, max_dec);
-        }
-        if (this->compare_abs(other) >= 0) {
-            int max_dec = std::max(this->decimal_pos, other.decimal_pos);
-            BigNumberDetail::UnsignedDigit a = this->magnitude;
-            BigNumberDetail::UnsignedDigit b = other.magnitude;
-            
-            int a_shift = max_dec - this->decimal_pos;
-            int b_shift = max_dec - other.decimal_pos;
-            if (a_shift > 0) {
-                a = a * BigNumberDetail::pow(BigNumberDetail::UnsignedDigit(10), a_shift);
-            }
-            if (b_shift > 0) {
-                b = b * BigNumberDetail::pow(BigNumberDetail::UnsignedDigit(10), b_shift);
-            }
-
-            return BigNumber(a - b, this->is_negative, max_dec);
-        }
-        return other + *this;
-    }
-    BigNumber operator-(const BigNumber& other) const {
-        BigNumber inverted_other = other;
-        inverted_other.is_negative = !inverted_other.is_negative;
-        if(inverted_other.magnitude.isZero()) inverted_other.is_negative = false;
-        return *this + inverted_other;
-    }
-    BigNumber operator*(const BigNumber& other) const {
+    BigNumber operator+(const BigNumber& other) const & { BigNumber result(*this); result += other; return result; }
+    BigNumber operator+(const BigNumber& other) && { *this += other; return std::move(*this); }
+    BigNumber operator-(const BigNumber& other) const & { BigNumber result(*this); result -= other; return result; }
+    BigNumber operator-(const BigNumber& other) && { *this -= other; return std::move(*this); }
+    BigNumber operator*(const BigNumber& other) const & {
         BigNumberDetail::UnsignedDigit res_mag = this->magnitude * other.magnitude;
         return BigNumber(res_mag, this->is_negative != other.is_negative, this->decimal_pos + other.decimal_pos);
     }
+    BigNumber operator*(const BigNumber& other) && { *this *= other; return std::move(*this); }
     BigNumber operator/(const BigNumber& other) const {
         if (other.magnitude.isZero()) throw std::runtime_error("Division by zero.");
         
@@ -492,12 +989,14 @@ public:
         
         BigNumberDetail::UnsignedDigit num = this->magnitude;
         if (scale_factor > 0) {
-            num = num * BigNumberDetail::pow(BigNumberDetail::UnsignedDigit(10), scale_factor);
+            num.scale10_in_place(scale_factor);
         }
         
         BigNumberDetail::UnsignedDigit quotient;
         if (scale_factor < 0) {
-            quotient = num / (other.magnitude * BigNumberDetail::pow(BigNumberDetail::UnsignedDigit(10), -scale_factor));
+            BigNumberDetail::UnsignedDigit den = other.magnitude;
+            den.scale10_in_place(-scale_factor);
+            quotient = num / den;
         } else {
             quotient = num / other.magnitude;
         }
@@ -513,12 +1012,49 @@ public:
         if (other.magnitude.isZero()) {
             throw std::runtime_error("Modulo by zero.");
         }
-        BigNumber quotient = this->exact_division(other);
-        return *this - (quotient * other);
+        BigNumber quotient, remainder;
+        divmod(*this, other, quotient, remainder);
+        return remainder;
     }
     
     BigNumber exact_division(const BigNumber& other) const; // to remove the extra zeros.
 
+    // Truncating division on the common scale of both operands, so no
+    // fractional digits are ever produced: a = quot * b + rem, where quot is
+    // an integer and rem carries the sign of a.
+    static void divmod(const BigNumber& a, const BigNumber& b, BigNumber& quot, BigNumber& rem) {
+        if (b.magnitude.isZero()) throw std::runtime_error("Division by zero.");
+        int dec = std::max(a.decimal_pos, b.decimal_pos);
+        BigNumberDetail::UnsignedDigit q, r;
+        a.scaled_magnitude(dec).divmod(b.scaled_magnitude(dec), q, r);
+        quot = BigNumber(q, a.is_negative != b.is_negative, 0);
+        rem = BigNumber(r, a.is_negative, dec);
+    }
+
+    // Aggregates over many values. sum() aligns every value to the largest
+    // scale and adds limbs without carrying; product() multiplies as a
+    // balanced tree so the large multiplications get operands of similar size.
+    static BigNumber sum(const std::vector<const BigNumber*>& values);
+    static BigNumber product(const std::vector<const BigNumber*>& values);
+    static BigNumber dot(const std::vector<const BigNumber*>& a, const std::vector<const BigNumber*>& b);
+
+    // Combinatorics on non-negative integers.
+    static BigNumber factorial(long long n) { return BigNumber(BigNumberDetail::CombHelper::range_product(2, n + 1), false, 0); }
+    static BigNumber perm(long long n, long long k) {
+        if (k > n) return BigNumber(0);
+        return BigNumber(BigNumberDetail::CombHelper::range_product(n - k + 1, n + 1), false, 0);
+    }
+    static BigNumber binomial(long long n, long long k) {
+        if (k > n) return BigNumber(0);
+        k = std::min(k, n - k);
+        return BigNumber(BigNumberDetail::CombHelper::range_product(n - k + 1, n + 1) / BigNumberDetail::CombHelper::range_product(2, k + 1), false, 0);
+    }
+    static BigNumber fibonacci(long long n) {
+        BigNumberDetail::UnsignedDigit f, g;
+        BigNumberDetail::CombHelper::fibonacci(n, f, g);
+        return BigNumber(f, false, 0);
+    }
+
     // 3. Comparison Operations
 
     bool operator==(const BigNumber& other) const { return this->is_negative == other.is_negative && this->compare_abs(other) == 0; }
@@ -571,25 +1107,10 @@ public:
         // Scale the number to treat it as a large integer
         int scale_factor = calc_precision * m - current_dec_pos;
         if (scale_factor > 0) {
-             // ================= FIX START =================
-             // Correctly scope UnsignedDigit with its namespace
-             n_val = n_val * BigNumberDetail::pow(BigNumberDetail::UnsignedDigit(10), scale_factor);
-             // ================= FIX END ===================
-        }
-
-        // Improved initial guess
-        std::string n_str = n_val.toString();
-        // ================= FIX START =================
-        // Correctly scope UnsignedDigit with its namespace
-        BigNumberDetail::UnsignedDigit x = BigNumberDetail::pow(BigNumberDetail::UnsignedDigit(10), (n_str.length() + m -1) / m);
-        // ================= FIX END ===================
-
-        BigNumberDetail::UnsignedDigit xx = (x * (m - 1) + n_val / BigNumberDetail::pow(x, m - 1)) / m;
-        while (xx < x) {
-            std::swap(x, xx);
-            xx = (x * (m - 1) + n_val / BigNumberDetail::pow(x, m - 1)) / m;
+             n_val.scale10_in_place(scale_factor);
         }
 
+        BigNumberDetail::UnsignedDigit x = BigNumberDetail::RootHelper::iroot(n_val, m);
         BigNumber result(x, num.is_negative, calc_precision);
         return result.approx(precision);
     }
@@ -640,6 +1161,8 @@ public:
     }
     
     long long toLongLong() const {
+        long long small;
+        if (toSmallInt(small)) return small;
         std::string s = this->toString();
         size_t dot = s.find('.');
         if(dot != std::string::npos) {
@@ -652,6 +1175,22 @@ public:
             throw std::runtime_error("BigNumber too large to fit in long long.");
         }
     }
+    // Overwrites the value with an integer, reusing the limb storage.
+    void assignSmallInt(long long n) {
+        is_negative = n < 0;
+        decimal_pos = 0;
+        unsigned long long m = n < 0 ? 0ULL - (unsigned long long)n : (unsigned long long)n;
+        magnitude.digits.clear();
+        do { magnitude.digits.push_back((int)(m % BigNumberDetail::MOD)); m /= BigNumberDetail::MOD; } while (m);
+    }
+    // Fast conversion for integers below 10^15 that skips the string round trip.
+    bool toSmallInt(long long& out) const {
+        if (decimal_pos != 0 || magnitude.size() > 3) return false;
+        long long v = 0;
+        for (int i = magnitude.size() - 1; i >= 0; --i) v = v * BigNumberDetail::MOD + magnitude.digits[i];
+        out = is_negative ? -v : v;
+        return true;
+    }
     double toDouble() const {
         try {
             return std::stod(this->toString());
@@ -660,11 +1199,21 @@ public:
         }
     }
 
+    // Big-endian base-256 conversions for bin values.
+    static BigNumber fromBytes(const std::vector<uint8_t>& bytes) {
+        return BigNumber(BigNumberDetail::RadixHelper::from_bytes(bytes.data(), bytes.size()), false, 0);
+    }
+    std::vector<uint8_t> toBytes() const {
+        if (is_negative || !isInteger()) throw std::runtime_error("Only non-negative integers can be converted to bin.");
+        if (decimal_pos == 0) return BigNumberDetail::RadixHelper::to_bytes(magnitude);
+        return BigNumberDetail::RadixHelper::to_bytes(magnitude / BigNumberDetail::pow(BigNumberDetail::UnsignedDigit(10), decimal_pos));
+    }
+
     // 6. State Checks
     bool isNegative() const { return is_negative; }
     bool isInteger() const {
-        std::string mag_str = magnitude.toString();
         if(decimal_pos == 0) return true;
+        std::string mag_str = magnitude.toString();
         if(decimal_pos >= (int)mag_str.length()) return magnitude.isZero();
 
         for(int i = 0; i < decimal_pos; ++i){
@@ -675,20 +1224,69 @@ public:
 };
 
 inline BigNumber BigNumber::exact_division(const BigNumber& other) const {
-    if (other.magnitude.isZero()) {
-        throw std::runtime_error("Division by zero.");
-    }
-    BigNumber quotient = *this / other;
-    if (quotient.decimal_pos == 0) {
-        return quotient;
+    BigNumber quotient, remainder;
+    divmod(*this, other, quotient, remainder);
+    return quotient;
+}
+
+
+// Positive and negative terms go to separate accumulators so that limbs never
+// have to borrow; the two totals are subtracted once at the end.
+inline BigNumber BigNumber::sum(const std::vector<const BigNumber*>& values) {
+    int dec = 0;
+    for (const BigNumber* v : values) dec = std::max(dec, v->decimal_pos);
+    BigNumberDetail::WideAccumulator pos, neg;
+    for (const BigNumber* v : values) {
+        if (v->magnitude.isZero()) continue;
+        int shift = dec - v->decimal_pos;
+        (v->is_negative ? neg : pos).add(v->magnitude, BigNumberDetail::POW10[shift % BigNumberDetail::BASE], shift / BigNumberDetail::BASE);
     }
-    std::string mag_str = quotient.magnitude.toString();
-    if (mag_str.length() <= (size_t)quotient.decimal_pos) {
-        return BigNumber(0);
+    BigNumber result(pos.result(), false, dec);
+    result.add_signed(BigNumber(neg.result(), false, dec), true);
+    return result;
+}
+
+inline BigNumber BigNumber::product(const std::vector<const BigNumber*>& values) {
+    if (values.empty()) return BigNumber(1);
+    std::vector<BigNumber> level;
+    level.reserve((values.size() + 1) / 2);
+    for (size_t i = 0; i < values.size(); i += 2)
+        level.push_back(i + 1 < values.size() ? *values[i] * *values[i + 1] : *values[i]);
+    while (level.size() > 1) {
+        size_t half = 0;
+        for (size_t i = 0; i < level.size(); i += 2)
+            level[half++] = i + 1 < level.size() ? level[i] * level[i + 1] : std::move(level[i]);
+        level.resize(half);
     }
-    std::string integer_part_str = mag_str.substr(0, mag_str.length() - quotient.decimal_pos);
-    return BigNumber(BigNumberDetail::UnsignedDigit(integer_part_str), quotient.is_negative, 0);
+    return level[0];
 }
 
+// Short products are added to the accumulator straight from the convolution,
+// before their own carries are propagated.
+inline BigNumber BigNumber::dot(const std::vector<const BigNumber*>& a, const std::vector<const BigNumber*>& b) {
+    using namespace BigNumberDetail;
+    const size_t RAW_LIMIT = 64;
+    size_t n = std::min(a.size(), b.size());
+    int dec = 0;
+    for (size_t i = 0; i < n; ++i) dec = std::max(dec, a[i]->decimal_pos + b[i]->decimal_pos);
+    WideAccumulator pos, neg;
+    for (size_t i = 0; i < n; ++i) {
+        const BigNumber& x = *a[i];
+        const BigNumber& y = *b[i];
+        if (x.magnitude.isZero() || y.magnitude.isZero()) continue;
+        int shift = dec - x.decimal_pos - y.decimal_pos;
+        WideAccumulator& acc = x.is_negative != y.is_negative ? neg : pos;
+        size_t shorter = std::min(x.magnitude.size(), y.magnitude.size());
+        if (shorter <= RAW_LIMIT) {
+            std::vector<ll> raw = ConvHelper::conv(x.magnitude.digits, y.magnitude.digits);
+            acc.add(raw.data(), raw.size(), POW10[shift % BASE], shift / BASE, (ll)(MOD - 1) * (MOD - 1) * (ll)shorter);
+        } else {
+            acc.add(x.magnitude * y.magnitude, POW10[shift % BASE], shift / BASE);
+        }
+    }
+    BigNumber result(pos.result(), false, dec);
+    result.add_signed(BigNumber(neg.result(), false, dec), true);
+    return result;
+}
 
 #endif // BIG_INT_HPP
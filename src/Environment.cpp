@@ -27,7 +27,7 @@ void Environment::assign(const std::string& name, ValuePtr value) {
         enclosing->assign(name, value);
         return;
     }
-    throw RuntimeError(0, fmt(Msg::UNDEFINED_VAR, name));
+    throw RuntimeError(0, Msg::UNDEFINED_VAR, {name});
 }
 
 void Environment::assign_local(const std::string& name, ValuePtr value) {
@@ -36,7 +36,7 @@ void Environment::assign_local(const std::string& name, ValuePtr value) {
         it->second = value;
         return;
     }
-    throw RuntimeError(0, fmt(Msg::UNDEFINED_VAR, name));
+    throw RuntimeError(0, Msg::UNDEFINED_VAR, {name});
 }
 
 ValuePtr Environment::get(const std::string& name) {
@@ -49,26 +49,44 @@ ValuePtr Environment::get(const std::string& name) {
     if (enclosing) {
         return enclosing->get(name);
     }
-    throw RuntimeError(0, fmt(Msg::UNDEFINED_VAR, name));
+    throw RuntimeError(0, Msg::UNDEFINED_VAR, {name});
 }
 
 ValuePtr Environment::get(const std::string& name) const {
     auto it = values.find(name);
     if (it != values.end()) return it->second;
     if (enclosing) return enclosing->get(name);
-    throw RuntimeError(0, fmt(Msg::UNDEFINED_VAR, name));
+    throw RuntimeError(0, Msg::UNDEFINED_VAR, {name});
+}
+
+ValuePtr Environment::try_get(const std::string& name) const {
+    for (const Environment* env = this; env; env = env->enclosing.get()) {
+        auto it = env->values.find(name);
+        if (it != env->values.end()) return it->second;
+    }
+    return nullptr;
+}
+
+ValuePtr* Environment::find_slot(const std::string& name) {
+    for (Environment* env = this; env; env = env->enclosing.get()) {
+        auto it = env->values.find(name);
+        if (it != env->values.end()) return &it->second;
+    }
+    return nullptr;
 }
 
 ValuePtr Environment::get_type(const std::string& name) {
     ValuePtr val = get(name);
-    if (dynamic_cast<NumberValue*>(val.get())) return std::make_shared<StringValue>("dec");
+    if (dynamic_cast<NumberValue*>(val.get()) || dynamic_cast<RationalValue*>(val.get())) return std::make_shared<StringValue>("dec");
     if (dynamic_cast<StringValue*>(val.get())) return std::make_shared<StringValue>("str");
     if (dynamic_cast<BinaryValue*>(val.get())) return std::make_shared<StringValue>("bin");
     if (dynamic_cast<LnValue*>(val.get())) return std::make_shared<StringValue>("ln");
     if (dynamic_cast<DimValue*>(val.get())) return std::make_shared<StringValue>("dim");
+    if (dynamic_cast<F64Value*>(val.get())) return std::make_shared<StringValue>("f64");
     if (dynamic_cast<ExceptionValue*>(val.get())) return std::make_shared<StringValue>("exception");
     if (dynamic_cast<Class*>(val.get())) return std::make_shared<StringValue>("class");
     if (dynamic_cast<Instance*>(val.get())) return std::make_shared<StringValue>("instance");
+    if (dynamic_cast<TableValue*>(val.get())) return std::make_shared<StringValue>("table");
     return std::make_shared<StringValue>("unknown");
 }
 
@@ -90,9 +108,9 @@ Instance::Instance(ClassPtr k) : klass(k) {
     for (const auto& field_def : klass->fields) {
         ValuePtr default_val;
         if (field_def.default_expr) {
-            default_val = std::make_shared<NullValue>();
+            default_val = NullValue::instance();
         } else {
-            default_val = field_def.default_value ? field_def.default_value->clone() : std::make_shared<NullValue>();
+            default_val = field_def.default_value ? copy_value(field_def.default_value) : NullValue::instance();
         }
         instance_env->define(field_def.name, default_val);
     }
@@ -103,7 +121,7 @@ ValuePtr Instance::clone() const {
     for (const auto& field_def : klass->fields) {
         try {
             ValuePtr field_val = instance_env->get(field_def.name);
-            new_inst->instance_env->define(field_def.name, field_val->clone());
+            new_inst->instance_env->define(field_def.name, copy_value(field_val));
         } catch (...) {}
     }
     return new_inst;
@@ -111,16 +129,20 @@ ValuePtr Instance::clone() const {
 
 ValuePtr Instance::get(const std::string& name) {
     if (DEBUG) std::cout << "DEBUG: Getting property '" << name << "' from " << klass->name << "'." << std::endl;
-    try {
-        return instance_env->get(name);
-    } catch (const RuntimeError&) {
-        auto it = klass->methods.find(name);
-        if (it != klass->methods.end()) {
-            if (DEBUG) std::cout << "DEBUG: Found method '" << name << "', creating bound method." << std::endl;
-            return std::make_shared<BoundMethodValue>(this->shared_from_this(), it->second);
-        }
+    if (ValuePtr field = instance_env->try_get(name)) return field;
+    auto it = klass->methods.find(name);
+    if (it != klass->methods.end()) {
+        if (DEBUG) std::cout << "DEBUG: Found method '" << name << "', creating bound method." << std::endl;
+        return std::make_shared<BoundMethodValue>(this->shared_from_this(), it->second);
     }
-    throw std::runtime_error(fmt(Msg::UNDEF_PROP, name));
+    throw RuntimeError(0, Msg::UNDEF_PROP, {name});
+}
+
+ValuePtr* Instance::field_slot(const std::string& name) {
+    for (const auto& field_def : klass->fields) {
+        if (field_def.name == name) return instance_env->find_slot(name);
+    }
+    return nullptr;
 }
 
 void Instance::set(const std::string& name, ValuePtr value) {
@@ -130,27 +152,178 @@ void Instance::set(const std::string& name, ValuePtr value) {
     for (const auto& field_def : klass->fields) {
         if (field_def.name == name) {
             field_found = true;
+            value = promote_to_declared(field_def.type_keyword, value);
             if (!is_type_compatible(field_def.type_keyword, value)) {
-                std::stringstream ss;
-                ss << "字段 '" << name << "' 类型不匹配。期望 " << token_type_to_string(field_def.type_keyword) << ", 得到 ";
-                if (dynamic_cast<NumberValue*>(value.get())) ss << "dec";
-                else if (dynamic_cast<StringValue*>(value.get())) ss << "str";
-                else if (dynamic_cast<BinaryValue*>(value.get())) ss << "bin";
-                else if (dynamic_cast<LnValue*>(value.get())) ss << "ln";
-                else if (dynamic_cast<DimValue*>(value.get())) ss << "dim";
-                else ss << "unknown";
-                ss << "。";
-                throw std::runtime_error(ss.str());
+                throw RuntimeError(0, Msg::FIELD_TYPE, {name, token_type_to_string(field_def.type_keyword), value_type_to_string(value)});
             }
             break;
         }
     }
     if (!field_found) {
-        throw std::runtime_error(fmt(Msg::UNDEF_FIELD, name));
+        throw RuntimeError(0, Msg::UNDEF_FIELD, {name});
     }
     instance_env->define(name, value);
 }
 
+// TableValue
+static ValuePtr field_default(const ParameterDefinition& field_def) {
+    if (field_def.default_expr || !field_def.default_value) return std::make_shared<NullValue>();
+    return copy_value(field_def.default_value);
+}
+
+ValuePtr TableValue::Column::get(size_t row) const {
+    if (unboxed() && !present[row]) return std::make_shared<NullValue>();
+    if (type == TokenType::DEC) return std::make_shared<NumberValue>(decs[row]);
+    if (type == TokenType::F64) return std::make_shared<F64Value>(f64s[row]);
+    return values[row];
+}
+
+void TableValue::Column::put(size_t row, const ValuePtr& value) {
+    if (!unboxed()) { values[row] = value; return; }
+    present[row] = !dynamic_cast<NullValue*>(value.get());
+    if (!present[row]) return;
+    if (type == TokenType::F64) f64s[row] = static_cast<F64Value*>(value.get())->value;
+    else if (auto r_val = dynamic_cast<RationalValue*>(value.get())) decs[row] = r_val->value.toBigNumber();
+    else decs[row] = static_cast<NumberValue*>(value.get())->value;
+}
+
+void TableValue::Column::push(const ValuePtr& value, size_t count) {
+    if (!unboxed()) {
+        values.insert(values.end(), count, value);
+        return;
+    }
+    bool has_value = !dynamic_cast<NullValue*>(value.get());
+    present.insert(present.end(), count, has_value);
+    if (type == TokenType::F64) f64s.insert(f64s.end(), count, has_value ? static_cast<F64Value*>(value.get())->value : 0);
+    else if (!has_value) decs.resize(decs.size() + count);
+    else if (auto r_val = dynamic_cast<RationalValue*>(value.get())) decs.insert(decs.end(), count, r_val->value.toBigNumber());
+    else decs.insert(decs.end(), count, static_cast<NumberValue*>(value.get())->value);
+}
+
+template <typename T>
+static void keep_rows(std::vector<T>& v, const std::vector<size_t>& rows) {
+    std::vector<T> kept;
+    kept.reserve(rows.size());
+    for (size_t r : rows) kept.push_back(std::move(v[r]));
+    v.swap(kept);
+}
+
+void TableValue::Column::keep(const std::vector<size_t>& rows) {
+    if (type == TokenType::DEC) keep_rows(decs, rows);
+    else if (type == TokenType::F64) keep_rows(f64s, rows);
+    else keep_rows(values, rows);
+    if (unboxed()) keep_rows(present, rows);
+}
+
+TableValue::TableValue(ClassPtr k) : klass(k), rows(0) {
+    for (const auto& field_def : klass->fields) {
+        Column column;
+        column.type = field_def.type_keyword;
+        columns.push_back(std::move(column));
+    }
+}
+
+int TableValue::column_index(const std::string& name) const {
+    for (size_t i = 0; i < klass->fields.size(); ++i) {
+        if (klass->fields[i].name == name) return (int)i;
+    }
+    return -1;
+}
+
+ValuePtr TableValue::checked(size_t col, ValuePtr value) const {
+    const ParameterDefinition& field_def = klass->fields[col];
+    value = promote_to_declared(field_def.type_keyword, value);
+    if (!is_type_compatible(field_def.type_keyword, value)) {
+        throw RuntimeError(0, Msg::FIELD_TYPE, {field_def.name, token_type_to_string(field_def.type_keyword), value_type_to_string(value)});
+    }
+    return value;
+}
+
+void TableValue::set(size_t row, size_t col, ValuePtr value) {
+    columns[col].put(row, checked(col, value));
+}
+
+void TableValue::append(const std::vector<ValuePtr>& values) {
+    if (values.size() > columns.size()) throw std::runtime_error(msg(Msg::TABLE_TOO_MANY));
+    std::vector<ValuePtr> row;
+    for (size_t col = 0; col < columns.size(); ++col)
+        row.push_back(col < values.size() ? checked(col, values[col]) : field_default(klass->fields[col]));
+    for (size_t col = 0; col < columns.size(); ++col) columns[col].push(row[col]);
+    ++rows;
+}
+
+void TableValue::append_defaults(size_t count) {
+    for (size_t col = 0; col < columns.size(); ++col) {
+        ValuePtr value = field_default(klass->fields[col]);
+        // Boxed fields get their own copy of the default in every row.
+        if (columns[col].unboxed() || count == 1) columns[col].push(value, count);
+        else for (size_t i = 0; i < count; ++i) columns[col].push(copy_value(value));
+    }
+    rows += count;
+}
+
+void TableValue::append(Instance& instance) {
+    std::vector<ValuePtr> values;
+    for (const auto& field_def : klass->fields) values.push_back(instance.get(field_def.name));
+    append(values);
+}
+
+std::shared_ptr<TableValue> TableValue::select(const std::vector<size_t>& rows) const {
+    auto result = std::make_shared<TableValue>(*this);
+    for (auto& column : result->columns) column.keep(rows);
+    result->rows = rows.size();
+    return result;
+}
+
+size_t TableValue::row_index(const Value& index) const {
+    const NumberValue* num_val = dynamic_cast<const NumberValue*>(&index);
+    if (!num_val) throw std::runtime_error(msg(Msg::LN_IDX_NUM));
+    long long i;
+    try { i = num_val->value.toLongLong(); }
+    catch (...) { throw std::runtime_error(msg(Msg::LN_IDX_INV)); }
+    if (i < 0) i += rows;
+    if (i < 0 || i >= (long long)rows) throw std::runtime_error(msg(Msg::LN_IDX_OOB));
+    return i;
+}
+
+ValuePtr TableValue::getSubscript(const Value& index) const {
+    auto self = std::const_pointer_cast<TableValue>(shared_from_this());
+    return std::make_shared<RowValue>(self, row_index(index));
+}
+
+void TableValue::setSubscript(const Value& index, ValuePtr value) {
+    size_t row = row_index(index);
+    auto instance = std::dynamic_pointer_cast<Instance>(value);
+    if (!instance || instance->klass != klass) throw std::runtime_error(msg(Msg::TABLE_ROW));
+    for (size_t col = 0; col < columns.size(); ++col) set(row, col, instance->get(klass->fields[col].name));
+}
+
+// RowValue
+ValuePtr RowValue::clone() const {
+    auto copy = std::make_shared<Instance>(klass);
+    for (size_t col = 0; col < table->columns.size(); ++col)
+        copy->instance_env->define(klass->fields[col].name, copy_value(table->columns[col].get(row)));
+    return copy;
+}
+
+ValuePtr RowValue::get(const std::string& name) {
+    int col = table->column_index(name);
+    if (col < 0) throw RuntimeError(0, Msg::UNDEF_PROP, {name});
+    return table->columns[col].get(row);
+}
+
+void RowValue::set(const std::string& name, ValuePtr value) {
+    int col = table->column_index(name);
+    if (col < 0) throw RuntimeError(0, Msg::UNDEF_FIELD, {name});
+    table->set(row, col, value);
+}
+
+ValuePtr* RowValue::field_slot(const std::string& name) {
+    int col = table->column_index(name);
+    if (col < 0 || table->columns[col].unboxed()) return nullptr;
+    return &table->columns[col].values[row];
+}
+
 // BoundMethodValue implementations (need full Instance/Class/Function types)
 std::string BoundMethodValue::toString() const {
     return "<bound method " + instance->klass->name + "." + method->name + ">";
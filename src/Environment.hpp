@@ -4,6 +4,7 @@
 #include <memory>
 #include <stdexcept>
 #include <sstream>
+#include <vector>
 #include "Value.hpp"
 #include "Ast.hpp"
 
@@ -15,7 +16,11 @@ public:
     void assign_local(const std::string& name, ValuePtr value);
     ValuePtr get(const std::string& name);
     ValuePtr get(const std::string& name) const;
+    // Non-throwing lookup for names that may legitimately be absent; nullptr if unbound.
+    ValuePtr try_get(const std::string& name) const;
     ValuePtr get_type(const std::string& name);
+    // Returns the storage slot bound to `name` in this scope chain, or nullptr.
+    ValuePtr* find_slot(const std::string& name);
     const std::map<std::string, ValuePtr>& get_values() const { return values; }
 private:
     std::shared_ptr<Environment> enclosing;
@@ -46,6 +51,70 @@ public:
     std::string repr() const override { return toString(); }
     bool isTruthy() const override { return true; }
     ValuePtr clone() const override;
-    ValuePtr get(const std::string& name);
-    void set(const std::string& name, ValuePtr value);
+    virtual ValuePtr get(const std::string& name);
+    virtual void set(const std::string& name, ValuePtr value);
+    // Storage slot of a declared field, or nullptr for methods and unknown names.
+    virtual ValuePtr* field_slot(const std::string& name);
+protected:
+    // For subclasses that keep their fields elsewhere.
+    Instance(ClassPtr k, std::shared_ptr<Environment> env) : klass(k), instance_env(env) {}
+};
+
+// Struct-of-arrays storage for instances of one struct, created by table().
+// dec and f64 fields are kept unboxed in contiguous columns; fields of other
+// types hold their values directly.
+struct TableValue : public Value, public std::enable_shared_from_this<TableValue> {
+    struct Column {
+        TokenType type;
+        std::vector<BigNumber> decs;
+        std::vector<double> f64s;
+        std::vector<ValuePtr> values;
+        std::vector<char> present; // dec/f64 rows holding a value; fields without a default start out null
+
+        bool unboxed() const { return type == TokenType::DEC || type == TokenType::F64; }
+        ValuePtr get(size_t row) const;
+        void put(size_t row, const ValuePtr& value);
+        void push(const ValuePtr& value, size_t count = 1);
+        void keep(const std::vector<size_t>& rows); // Reorders and truncates to `rows`
+    };
+
+    ClassPtr klass;
+    std::vector<Column> columns;
+    size_t rows;
+
+    TableValue(ClassPtr k);
+    std::string toString() const override { return "<" + klass->name + " table, " + std::to_string(rows) + " rows>"; }
+    std::string repr() const override { return toString(); }
+    bool isTruthy() const override { return rows > 0; }
+    ValuePtr clone() const override { return std::make_shared<TableValue>(*this); }
+    ValuePtr getSubscript(const Value& index) const override;
+    void setSubscript(const Value& index, ValuePtr value) override;
+
+    // Index of a field's column, or -1.
+    int column_index(const std::string& name) const;
+    // Stores a value in a field after the same promotion and type check as Instance::set.
+    void set(size_t row, size_t col, ValuePtr value);
+    // Appends a row from field values in declaration order; missing ones take their defaults.
+    void append(const std::vector<ValuePtr>& values);
+    void append(Instance& instance);
+    // Appends `count` rows holding the field defaults.
+    void append_defaults(size_t count);
+    // A new table holding the given rows in that order.
+    std::shared_ptr<TableValue> select(const std::vector<size_t>& rows) const;
+private:
+    size_t row_index(const Value& index) const;
+    ValuePtr checked(size_t col, ValuePtr value) const;
+};
+
+// A row of a table, used like an instance of its struct. Reads and writes go
+// straight to the table's columns.
+struct RowValue : public Instance {
+    std::shared_ptr<TableValue> table;
+    size_t row;
+    RowValue(std::shared_ptr<TableValue> t, size_t r) : Instance(t->klass, nullptr), table(std::move(t)), row(r) {}
+    std::string toString() const override { return "<" + klass->name + " row " + std::to_string(row) + ">"; }
+    ValuePtr clone() const override;
+    ValuePtr get(const std::string& name) override;
+    void set(const std::string& name, ValuePtr value) override;
+    ValuePtr* field_slot(const std::string& name) override;
 };
@@ -0,0 +1,206 @@
+#pragma once
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <typeinfo>
+#include <vector>
+#include "Value.hpp"
+#include "msgs.hpp"
+
+// Compiled format string shared by f"..." literals and format(). Literal text
+// is split out once; rendering converts each argument, reserves the exact
+// result size and appends the pieces in order.
+//
+// Placeholders are `{field}` or `{field:spec}`, where spec is
+// [[fill]align][0][width][.precision][f|s]: align is < > or ^, and precision
+// gives dec/f64 values that many decimals and cuts other values to that many
+// characters. `{{` and `}}` stand for literal braces.
+class FormatTemplate {
+public:
+    struct Spec {
+        char fill = ' ';
+        char align = 0;      // '<', '>', '^', '=' (pad after the sign), or 0 for the default
+        int width = -1;
+        int precision = -1;
+        char type = 0;       // 'f', 's' or 0
+        bool plain() const { return width < 0 && precision < 0; }
+    };
+
+    // Splits `fmt` into literal text and placeholders. `on_field` gets each
+    // placeholder's text before the spec and returns the argument index it
+    // reads. Throws std::runtime_error on unbalanced braces or a bad spec.
+    template <class OnField>
+    static FormatTemplate compile(const std::string& fmt, OnField on_field) {
+        FormatTemplate result;
+        std::string literal;
+        for (size_t i = 0; i < fmt.size(); ++i) {
+            char c = fmt[i];
+            if (c == '}') {
+                if (i + 1 < fmt.size() && fmt[i + 1] == '}') { literal += '}'; ++i; continue; }
+                throw std::runtime_error(msg(Msg::FORMAT_BRACE));
+            }
+            if (c != '{') { literal += c; continue; }
+            if (i + 1 < fmt.size() && fmt[i + 1] == '{') { literal += '{'; ++i; continue; }
+            size_t close, colon;
+            find_field_end(fmt, i + 1, close, colon);
+            Piece piece;
+            piece.literal.swap(literal);
+            piece.arg = on_field(fmt.substr(i + 1, colon - i - 1));
+            if (colon < close) piece.spec = parse_spec(fmt.substr(colon + 1, close - colon - 1));
+            result.literal_size += piece.literal.size();
+            result.pieces.push_back(std::move(piece));
+            i = close;
+        }
+        result.tail = literal;
+        result.literal_size += literal.size();
+        return result;
+    }
+
+    std::string render(const std::vector<ValuePtr>& args) const {
+        std::vector<std::string> texts(pieces.size());
+        std::vector<const std::string*> parts(pieces.size());
+        size_t total = literal_size;
+        for (size_t i = 0; i < pieces.size(); ++i) {
+            const Piece& piece = pieces[i];
+            if (piece.arg >= args.size()) throw std::runtime_error(msg(Msg::FORMAT_ARGS));
+            const Value& value = *args[piece.arg];
+            if (piece.spec.plain() && typeid(value) == typeid(StringValue)) {
+                parts[i] = &static_cast<const StringValue&>(value).value;
+            } else {
+                texts[i] = format_value(value, piece.spec);
+                parts[i] = &texts[i];
+            }
+            total += parts[i]->size();
+        }
+        std::string out;
+        out.reserve(total);
+        for (size_t i = 0; i < pieces.size(); ++i) {
+            out += pieces[i].literal;
+            out += *parts[i];
+        }
+        out += tail;
+        return out;
+    }
+
+private:
+    struct Piece {
+        std::string literal; // Text before the placeholder
+        size_t arg = 0;
+        Spec spec;
+    };
+    std::vector<Piece> pieces;
+    std::string tail;
+    size_t literal_size = 0;
+
+    // Finds the `}` closing a field that starts at `from`, skipping brackets
+    // and quoted strings so an f-string expression may contain them. `colon`
+    // is the start of the spec, or `close` when there is none.
+    static void find_field_end(const std::string& fmt, size_t from, size_t& close, size_t& colon) {
+        int depth = 0;
+        char quote = 0;
+        colon = std::string::npos;
+        for (size_t i = from; i < fmt.size(); ++i) {
+            char c = fmt[i];
+            if (quote) { if (c == quote) quote = 0; continue; }
+            switch (c) {
+                case '"': case '\'': quote = c; break;
+                case '(': case '[': case '{': ++depth; break;
+                case ')': case ']': --depth; break;
+                case ':': if (depth == 0 && colon == std::string::npos) colon = i; break;
+                case '}':
+                    if (depth > 0) { --depth; break; }
+                    close = i;
+                    if (colon == std::string::npos) colon = i;
+                    return;
+            }
+        }
+        throw std::runtime_error(msg(Msg::FORMAT_BRACE));
+    }
+
+    static Spec parse_spec(const std::string& s) {
+        Spec spec;
+        size_t i = 0;
+        auto is_align = [](char c) { return c == '<' || c == '>' || c == '^'; };
+        if (s.size() >= 2 && is_align(s[1]) && (unsigned char)s[0] < 0x80) { spec.fill = s[0]; spec.align = s[1]; i = 2; }
+        else if (!s.empty() && is_align(s[0])) { spec.align = s[0]; i = 1; }
+        if (i < s.size() && s[i] == '0' && !spec.align) { spec.fill = '0'; spec.align = '='; ++i; }
+        auto read_int = [&s, &i]() {
+            int n = 0;
+            while (i < s.size() && s[i] >= '0' && s[i] <= '9') {
+                n = n * 10 + (s[i++] - '0');
+                if (n > MAX_WIDTH) throw std::runtime_error(msg(Msg::FORMAT_SPEC));
+            }
+            return n;
+        };
+        if (i < s.size() && s[i] >= '0' && s[i] <= '9') spec.width = read_int();
+        if (i < s.size() && s[i] == '.') {
+            ++i;
+            if (i == s.size() || s[i] < '0' || s[i] > '9') throw std::runtime_error(msg(Msg::FORMAT_SPEC));
+            spec.precision = read_int();
+        }
+        if (i < s.size() && (s[i] == 'f' || s[i] == 's')) spec.type = s[i++];
+        if (i != s.size()) throw std::runtime_error(msg(Msg::FORMAT_SPEC));
+        return spec;
+    }
+
+    static const int MAX_WIDTH = 100000;
+
+    static bool is_number(const Value& v) {
+        return typeid(v) == typeid(NumberValue) || typeid(v) == typeid(F64Value) || typeid(v) == typeid(RationalValue);
+    }
+
+    // Characters as the user sees them: UTF-8 continuation bytes don't count.
+    static size_t text_width(const std::string& s) {
+        size_t n = 0;
+        for (unsigned char c : s) n += (c & 0xC0) != 0x80;
+        return n;
+    }
+
+    static std::string fixed(const Value& v, int precision) {
+        if (typeid(v) == typeid(F64Value)) {
+            double d = static_cast<const F64Value&>(v).value;
+            int len = std::snprintf(nullptr, 0, "%.*f", precision, d);
+            std::string s(len, '\0');
+            std::snprintf(&s[0], len + 1, "%.*f", precision, d);
+            return s;
+        }
+        BigNumber n = typeid(v) == typeid(RationalValue) ? static_cast<const RationalValue&>(v).value.toBigNumber(precision)
+                                                          : static_cast<const NumberValue&>(v).value.approx(precision);
+        std::string s = n.toString();
+        if (precision == 0) return s;
+        size_t dot = s.find('.');
+        size_t decimals = dot == std::string::npos ? 0 : s.size() - dot - 1;
+        if (dot == std::string::npos) s += '.';
+        s.append(precision - decimals, '0');
+        return s;
+    }
+
+    static std::string format_value(const Value& v, const Spec& spec) {
+        bool number = is_number(v) && spec.type != 's';
+        if (spec.type == 'f' && !number) throw std::runtime_error(msg(Msg::FORMAT_SPEC));
+        std::string s;
+        if (number && spec.precision >= 0) s = fixed(v, spec.precision);
+        else s = v.toString();
+        if (!number && spec.precision >= 0) {
+            size_t keep = 0, seen = 0;
+            while (keep < s.size() && (seen < (size_t)spec.precision || ((unsigned char)s[keep] & 0xC0) == 0x80)) {
+                if (((unsigned char)s[keep] & 0xC0) != 0x80) ++seen;
+                ++keep;
+            }
+            s.resize(keep);
+        }
+        size_t width = text_width(s);
+        if (spec.width < 0 || width >= (size_t)spec.width) return s;
+        size_t pad = spec.width - width;
+        char align = spec.align ? spec.align : (number ? '>' : '<');
+        switch (align) {
+            case '<': return s + std::string(pad, spec.fill);
+            case '^': return std::string(pad / 2, spec.fill) + s + std::string(pad - pad / 2, spec.fill);
+            case '=': {
+                size_t sign = number && !s.empty() && s[0] == '-' ? 1 : 0;
+                return s.substr(0, sign) + std::string(pad, spec.fill) + s.substr(sign);
+            }
+            default: return std::string(pad, spec.fill) + s;
+        }
+    }
+};
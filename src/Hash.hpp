@@ -0,0 +1,176 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Byte-oriented hash functions for the hash natives. Inputs are raw buffers so
+// strings and bins are hashed in place, without a toString() round trip.
+namespace Hash {
+
+    inline uint64_t read64(const uint8_t* p) { uint64_t v; std::memcpy(&v, p, 8); return v; }
+    inline uint32_t read32(const uint8_t* p) { uint32_t v; std::memcpy(&v, p, 4); return v; }
+    inline uint64_t rotl64(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+    inline uint32_t rotr32(uint32_t x, int r) { return (x >> r) | (x << (32 - r)); }
+
+    // ---- xxHash64 ----
+
+    const uint64_t XX_P1 = 0x9E3779B185EBCA87ULL;
+    const uint64_t XX_P2 = 0xC2B2AE3D27D4EB4FULL;
+    const uint64_t XX_P3 = 0x165667B19E3779F9ULL;
+    const uint64_t XX_P4 = 0x85EBCA77C2B2AE63ULL;
+    const uint64_t XX_P5 = 0x27D4EB2F165667C5ULL;
+
+    inline uint64_t xx_round(uint64_t acc, uint64_t input) {
+        acc += input * XX_P2;
+        return rotl64(acc, 31) * XX_P1;
+    }
+    inline uint64_t xx_merge(uint64_t acc, uint64_t val) {
+        acc ^= xx_round(0, val);
+        return acc * XX_P1 + XX_P4;
+    }
+
+    inline uint64_t xxhash64(const uint8_t* p, size_t len, uint64_t seed = 0) {
+        const uint8_t* end = p + len;
+        uint64_t h;
+        if (len >= 32) {
+            // Four independent lanes keep the multiplier pipeline full.
+            uint64_t v1 = seed + XX_P1 + XX_P2, v2 = seed + XX_P2, v3 = seed, v4 = seed - XX_P1;
+            const uint8_t* limit = end - 32;
+            do {
+                v1 = xx_round(v1, read64(p));
+                v2 = xx_round(v2, read64(p + 8));
+                v3 = xx_round(v3, read64(p + 16));
+                v4 = xx_round(v4, read64(p + 24));
+                p += 32;
+            } while (p <= limit);
+            h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+            h = xx_merge(h, v1);
+            h = xx_merge(h, v2);
+            h = xx_merge(h, v3);
+            h = xx_merge(h, v4);
+        } else {
+            h = seed + XX_P5;
+        }
+        h += len;
+        for (; p + 8 <= end; p += 8) h = rotl64(h ^ xx_round(0, read64(p)), 27) * XX_P1 + XX_P4;
+        if (p + 4 <= end) { h = rotl64(h ^ (read32(p) * XX_P1), 23) * XX_P2 + XX_P3; p += 4; }
+        for (; p < end; ++p) h = rotl64(h ^ (*p * XX_P5), 11) * XX_P1;
+        h ^= h >> 33;
+        h *= XX_P2;
+        h ^= h >> 29;
+        h *= XX_P3;
+        h ^= h >> 32;
+        return h;
+    }
+
+    // ---- CRC-32 (IEEE 802.3, slicing-by-8) ----
+
+    inline const uint32_t (&crc32_tables())[8][256] {
+        static uint32_t tables[8][256];
+        static bool ready = false;
+        if (!ready) {
+            for (uint32_t i = 0; i < 256; ++i) {
+                uint32_t c = i;
+                for (int k = 0; k < 8; ++k) c = (c >> 1) ^ (0xEDB88320u & (0u - (c & 1)));
+                tables[0][i] = c;
+            }
+            for (uint32_t i = 0; i < 256; ++i)
+                for (int t = 1; t < 8; ++t)
+                    tables[t][i] = (tables[t - 1][i] >> 8) ^ tables[0][tables[t - 1][i] & 0xFF];
+            ready = true;
+        }
+        return tables;
+    }
+
+    inline uint32_t crc32(const uint8_t* p, size_t len) {
+        const uint32_t (&t)[8][256] = crc32_tables();
+        uint32_t c = 0xFFFFFFFFu;
+        for (; len >= 8; len -= 8, p += 8) {
+            uint32_t lo = read32(p) ^ c, hi = read32(p + 4);
+            c = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF] ^ t[5][(lo >> 16) & 0xFF] ^ t[4][lo >> 24] ^
+                t[3][hi & 0xFF] ^ t[2][(hi >> 8) & 0xFF] ^ t[1][(hi >> 16) & 0xFF] ^ t[0][hi >> 24];
+        }
+        for (; len; --len, ++p) c = (c >> 8) ^ t[0][(c ^ *p) & 0xFF];
+        return c ^ 0xFFFFFFFFu;
+    }
+
+    // ---- SHA-256 ----
+
+    inline std::vector<uint8_t> sha256(const uint8_t* data, size_t len) {
+        static const uint32_t K[64] = {
+            0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+            0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+            0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+            0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+            0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+            0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+            0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+            0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+        uint32_t h[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+
+        auto compress = [&](const uint8_t* block) {
+            uint32_t w[64];
+            for (int i = 0; i < 16; ++i)
+                w[i] = (uint32_t)block[4 * i] << 24 | (uint32_t)block[4 * i + 1] << 16 | (uint32_t)block[4 * i + 2] << 8 | block[4 * i + 3];
+            for (int i = 16; i < 64; ++i) {
+                uint32_t s0 = rotr32(w[i - 15], 7) ^ rotr32(w[i - 15], 18) ^ (w[i - 15] >> 3);
+                uint32_t s1 = rotr32(w[i - 2], 17) ^ rotr32(w[i - 2], 19) ^ (w[i - 2] >> 10);
+                w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+            }
+            uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4], f = h[5], g = h[6], k = h[7];
+            for (int i = 0; i < 64; ++i) {
+                uint32_t t1 = k + (rotr32(e, 6) ^ rotr32(e, 11) ^ rotr32(e, 25)) + ((e & f) ^ (~e & g)) + K[i] + w[i];
+                uint32_t t2 = (rotr32(a, 2) ^ rotr32(a, 13) ^ rotr32(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+                k = g; g = f; f = e; e = d + t1; d = c; c = b; b = a; a = t1 + t2;
+            }
+            h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e; h[5] += f; h[6] += g; h[7] += k;
+        };
+
+        size_t full = len / 64 * 64;
+        for (size_t i = 0; i < full; i += 64) compress(data + i);
+        uint8_t tail[128] = {0};
+        size_t rest = len - full;
+        std::memcpy(tail, data + full, rest);
+        tail[rest] = 0x80;
+        size_t tail_len = rest + 9 <= 64 ? 64 : 128;
+        uint64_t bits = (uint64_t)len * 8;
+        for (int i = 0; i < 8; ++i) tail[tail_len - 1 - i] = (uint8_t)(bits >> (8 * i));
+        for (size_t i = 0; i < tail_len; i += 64) compress(tail + i);
+
+        std::vector<uint8_t> digest(32);
+        for (int i = 0; i < 8; ++i)
+            for (int j = 0; j < 4; ++j) digest[4 * i + j] = (uint8_t)(h[i] >> (24 - 8 * j));
+        return digest;
+    }
+
+    // ---- SipHash-2-4 ----
+
+    inline uint64_t siphash(const uint8_t* p, size_t len, uint64_t k0, uint64_t k1) {
+        uint64_t v0 = 0x736f6d6570736575ULL ^ k0, v1 = 0x646f72616e646f6dULL ^ k1;
+        uint64_t v2 = 0x6c7967656e657261ULL ^ k0, v3 = 0x7465646279746573ULL ^ k1;
+        auto sipround = [&]() {
+            v0 += v1; v1 = rotl64(v1, 13); v1 ^= v0; v0 = rotl64(v0, 32);
+            v2 += v3; v3 = rotl64(v3, 16); v3 ^= v2;
+            v0 += v3; v3 = rotl64(v3, 21); v3 ^= v0;
+            v2 += v1; v1 = rotl64(v1, 17); v1 ^= v2; v2 = rotl64(v2, 32);
+        };
+        const uint8_t* end = p + len - len % 8;
+        for (; p != end; p += 8) {
+            uint64_t m = read64(p);
+            v3 ^= m; sipround(); sipround(); v0 ^= m;
+        }
+        uint64_t b = (uint64_t)len << 56;
+        for (int i = len % 8 - 1; i >= 0; --i) b |= (uint64_t)p[i] << (8 * i);
+        v3 ^= b; sipround(); sipround(); v0 ^= b;
+        v2 ^= 0xFF;
+        sipround(); sipround(); sipround(); sipround();
+        return v0 ^ v1 ^ v2 ^ v3;
+    }
+
+    // Folds a child hash into a running structural hash.
+    inline uint64_t combine(uint64_t seed, uint64_t h) {
+        return seed ^ (h + 0x9E3779B97F4A7C15ULL + (seed << 6) + (seed >> 2));
+    }
+
+} // namespace Hash
@@ -1,20 +1,93 @@
 #include "Interpreter.hpp"
 #include "msg_cn.hpp"
+#include "Random.hpp"
+#include "Hash.hpp"
+#include "Memo.hpp"
+#include "Format.hpp"
+#include "StringOps.hpp"
 #include <iostream>
 #include <sstream>
 #include <algorithm>
 #include <set>
 #include <thread>
 #include <cstdlib>
+#include <climits>
 #include <fstream>
 #include <sys/stat.h>
+#include <typeinfo>
 
 #ifndef DEBUG
 constexpr bool DEBUG = false;
 #endif
 
+const size_t MemoCache::DEFAULT_CAPACITY;
+
+const char* RuntimeError::what() const noexcept {
+    if (!lazy) return std::runtime_error::what();
+    if (text.empty()) text = fmt_args(id, args);
+    return text.c_str();
+}
+
+// ===== Quickening helpers =====
+
+// Exact-type probe used by quickened nodes; cheaper than a dynamic_cast chain.
+static inline const NumberValue* exact_number(const ValuePtr& v) {
+    return typeid(*v) == typeid(NumberValue) ? static_cast<const NumberValue*>(v.get()) : nullptr;
+}
+
+// Truth values are never mutated, so every comparison site shares the same two.
+static ValuePtr bool_value(bool b) {
+    static const ValuePtr true_value = std::make_shared<NumberValue>(1);
+    static const ValuePtr false_value = std::make_shared<NumberValue>(0);
+    return b ? true_value : false_value;
+}
+
+static bool compare_numbers(TokenType op, const BigNumber& l, const BigNumber& r) {
+    switch (op) {
+        case TokenType::EQUAL_EQUAL: return l == r;
+        case TokenType::BANG_EQUAL: return l != r;
+        case TokenType::LESS: return l < r;
+        case TokenType::LESS_EQUAL: return l <= r;
+        case TokenType::GREATER: return l > r;
+        default: return l >= r;
+    }
+}
+
+static bool compare_values(TokenType op, const Value& l, const Value& r) {
+    switch (op) {
+        case TokenType::EQUAL_EQUAL: return l.isEqualTo(r);
+        case TokenType::BANG_EQUAL: return !l.isEqualTo(r);
+        case TokenType::LESS: return l.isLessThan(r);
+        case TokenType::LESS_EQUAL: return l.isLessEqual(r);
+        case TokenType::GREATER: return r.isLessThan(l);
+        default: return r.isLessEqual(l);
+    }
+}
+
+// Shared by `f64 x = ...` and `as f64`.
+static ValuePtr convert_to_f64(const ValuePtr& val, int line) {
+    if (dynamic_cast<NumberValue*>(val.get()) || dynamic_cast<RationalValue*>(val.get())) {
+        try { return promote_to_declared(TokenType::F64, val); }
+        catch (const std::runtime_error& e) { throw RuntimeError(line, e.what()); }
+    }
+    if (auto s_val = dynamic_cast<StringValue*>(val.get())) {
+        const char* begin = s_val->value.c_str();
+        char* end = nullptr;
+        double d = strtod(begin, &end);
+        if (end == begin || *end != '\0') throw RuntimeError(line, Msg::STR_TO_NUM, {s_val->value});
+        return std::make_shared<F64Value>(d);
+    }
+    if (auto b_val = dynamic_cast<BinaryValue*>(val.get())) return std::make_shared<F64Value>(b_val->toBigNumber().toDouble());
+    if (dynamic_cast<NullValue*>(val.get())) return std::make_shared<F64Value>(0.0);
+    throw RuntimeError(line, "Unsupported conversion to 'f64'.");
+}
+
 // ===== AST accept() implementations =====
 
+bool AstNode::test(Interpreter& visitor) {
+    return accept(visitor)->isTruthy();
+}
+
 ValuePtr LiteralNode::accept(Interpreter& visitor) {
     return value;
 }
@@ -25,6 +98,14 @@ ValuePtr ListLiteralNode::accept(Interpreter& visitor) {
     return std::make_shared<LnValue>(evaluated_elements);
 }
 
+ValuePtr FormatStringNode::accept(Interpreter& visitor) {
+    std::vector<ValuePtr> values;
+    values.reserve(args.size());
+    for (const auto& arg : args) values.push_back(visitor.evaluate(arg));
+    try { return std::make_shared<StringValue>(format->render(values)); }
+    catch (const std::runtime_error& e) { throw RuntimeError(line, e.what()); }
+}
+
 ValuePtr DimLiteralNode::accept(Interpreter& visitor) {
     std::map<std::string, ValuePtr> result;
     for (const auto& entry : entries) {
@@ -48,49 +129,177 @@ ValuePtr VariableNode::accept(Interpreter& visitor) {
         }
         return val;
     }
-    catch (RuntimeError& e) { throw RuntimeError(line, e.what()); }
+    catch (RuntimeError& e) { e.line = line; throw; }
 }
 
 ValuePtr AssignmentNode::accept(Interpreter& visitor) {
+    if (self_update == Quickened::UNSEEN) {
+        self_update = Quickened::GENERIC;
+        auto var_node = dynamic_cast<VariableNode*>(target.get());
+        auto bin_node = dynamic_cast<BinaryOpNode*>(value.get());
+        if (var_node && bin_node) {
+            auto lhs = dynamic_cast<VariableNode*>(bin_node->left.get());
+            bool simple_rhs = dynamic_cast<LiteralNode*>(bin_node->right.get()) || dynamic_cast<VariableNode*>(bin_node->right.get());
+            if (lhs && lhs->name == var_node->name && simple_rhs) self_update = Quickened::NUMBERS;
+        }
+    }
+    if (self_update == Quickened::NUMBERS) {
+        // Superinstruction for `x = x <op> y`: the variable slot is resolved
+        // once and both the read and the write go through it.
+        auto var_node = static_cast<VariableNode*>(target.get());
+        auto bin_node = static_cast<BinaryOpNode*>(value.get());
+        ValuePtr* slot = visitor.environment->find_slot(var_node->name);
+        if (slot && !dynamic_cast<ModuleProxy*>(slot->get())) {
+            ValuePtr current = *slot;
+            ValuePtr rhs = visitor.evaluate(bin_node->right);
+            ValuePtr val = bin_node->apply(current, rhs);
+            *slot = val;
+            return val;
+        }
+    }
     auto val = visitor.evaluate(value);
     if (auto get_node = dynamic_cast<GetNode*>(target.get())) {
-        try {
-            auto object = visitor.evaluate(get_node->object);
-            if (auto instance = std::dynamic_pointer_cast<Instance>(object)) {
-                instance->set(get_node->name, val);
-            } else {
-                throw RuntimeError(line, msg(Msg::NO_SET_PROP));
-            }
-        } catch (const std::runtime_error& e) {
-            throw RuntimeError(line, e.what());
-        }
+        auto object = visitor.evaluate(get_node->object);
+        auto instance = std::dynamic_pointer_cast<Instance>(object);
+        if (!instance) throw RuntimeError(line, msg(Msg::NO_SET_PROP));
+        try { instance->set(get_node->name, val); }
+        catch (RuntimeError& e) { e.line = line; throw; }
     } else {
         visitor.assignToLValue(target, val, line);
     }
     return val;
 }
 
+// Applies `stored <op>= rhs` to the value object itself. Only allowed when the
+// slot still holds `current` and nothing but the slot and the caller's copy
+// reference it, so no other name or container can observe the mutation.
+static bool update_in_place(const ValuePtr& stored, const ValuePtr& current, TokenType op, const ValuePtr& rhs) {
+    if (stored.get() != current.get() || current.use_count() != 2) return false;
+    const std::type_info& type = typeid(*current);
+    if (type == typeid(NumberValue)) {
+        const NumberValue* r = exact_number(rhs);
+        if (!r) return false;
+        BigNumber& value = static_cast<NumberValue*>(current.get())->value;
+        switch (op) {
+            case TokenType::PLUS: value += r->value; return true;
+            case TokenType::MINUS: value -= r->value; return true;
+            case TokenType::STAR: value *= r->value; return true;
+            default: return false;
+        }
+    }
+    if (type == typeid(F64Value)) {
+        double r;
+        if (typeid(*rhs) == typeid(F64Value)) r = static_cast<F64Value*>(rhs.get())->value;
+        else if (const NumberValue* n = exact_number(rhs)) r = n->value.toDouble();
+        else return false;
+        double& value = static_cast<F64Value*>(current.get())->value;
+        switch (op) {
+            case TokenType::PLUS: value += r; return true;
+            case TokenType::MINUS: value -= r; return true;
+            case TokenType::STAR: value *= r; return true;
+            case TokenType::SLASH: value /= r; return true;
+            default: return false;
+        }
+    }
+    if (op != TokenType::PLUS) return false;
+    if (type == typeid(StringValue)) {
+        static_cast<StringValue*>(current.get())->value += rhs->toString();
+        return true;
+    }
+    if (type == typeid(LnValue) && typeid(*rhs) == typeid(LnValue)) {
+        auto& elements = static_cast<LnValue*>(current.get())->elements;
+        const auto& extra = static_cast<LnValue*>(rhs.get())->elements;
+        elements.insert(elements.end(), extra.begin(), extra.end());
+        return true;
+    }
+    return false;
+}
+
+ValuePtr CompoundAssignmentNode::accept(Interpreter& visitor) {
+    TokenType op = operation->op;
+    if (auto var_node = dynamic_cast<VariableNode*>(target.get())) {
+        ValuePtr* slot = visitor.environment->find_slot(var_node->name);
+        ValuePtr current = (slot && typeid(**slot) != typeid(ModuleProxy)) ? *slot : visitor.evaluate(target);
+        ValuePtr rhs = visitor.evaluate(operation->right);
+        if (!slot) slot = visitor.environment->find_slot(var_node->name);
+        if (update_in_place(*slot, current, op, rhs)) return current;
+        ValuePtr val = operation->apply(current, rhs);
+        *slot = val;
+        return val;
+    }
+    if (auto sub_node = dynamic_cast<SubscriptNode*>(target.get())) {
+        ValuePtr object = visitor.evaluate(sub_node->object);
+        if (!sub_node->is_slice) {
+            ValuePtr index = visitor.evaluate(sub_node->start);
+            ValuePtr current;
+            try { current = object->getSubscript(*index); }
+            catch (const std::runtime_error& e) { throw RuntimeError(line, e.what()); }
+            ValuePtr rhs = visitor.evaluate(operation->right);
+            ValuePtr* slot = object->getSubscriptSlot(*index);
+            if (slot && update_in_place(*slot, current, op, rhs)) return current;
+            ValuePtr val = operation->apply(current, rhs);
+            try { object->setSubscript(*index, val); }
+            catch (const std::runtime_error& e) { throw RuntimeError(line, e.what()); }
+            return val;
+        }
+        ValuePtr start_v = sub_node->start ? visitor.evaluate(sub_node->start) : std::make_shared<NullValue>();
+        ValuePtr end_v = sub_node->end ? visitor.evaluate(sub_node->end) : std::make_shared<NullValue>();
+        ValuePtr step_v = sub_node->step ? visitor.evaluate(sub_node->step) : std::make_shared<NullValue>();
+        ValuePtr current;
+        try { current = object->getSlice(start_v, end_v, step_v); }
+        catch (const std::runtime_error& e) { throw RuntimeError(line, e.what()); }
+        ValuePtr val = operation->apply(current, visitor.evaluate(operation->right));
+        try { object->setSlice(start_v, end_v, step_v, val); }
+        catch (const std::runtime_error& e) { throw RuntimeError(line, e.what()); }
+        return val;
+    }
+    auto get_node = static_cast<GetNode*>(target.get());
+    auto instance = std::dynamic_pointer_cast<Instance>(visitor.evaluate(get_node->object));
+    if (!instance) throw RuntimeError(line, msg(Msg::NO_SET_PROP));
+    ValuePtr current;
+    try { current = instance->get(get_node->name); }
+    catch (RuntimeError& e) { e.line = line; throw; }
+    ValuePtr rhs = visitor.evaluate(operation->right);
+    // In-place updates keep the value's type, so the field type check still holds.
+    ValuePtr* slot = instance->field_slot(get_node->name);
+    if (slot && update_in_place(*slot, current, op, rhs)) return current;
+    ValuePtr val = operation->apply(current, rhs);
+    try { instance->set(get_node->name, val); }
+    catch (RuntimeError& e) { e.line = line; throw; }
+    return val;
+}
+
 ValuePtr VarDeclarationNode::accept(Interpreter& visitor) {
     ValuePtr val = std::make_shared<NullValue>();
     if (initializer) { val = visitor.evaluate(initializer); }
-    if (keyword.type == TokenType::DEC) {
+    if (keyword == TokenType::DEC) {
         if (auto s_val = dynamic_cast<StringValue*>(val.get())) {
             try { val = std::make_shared<NumberValue>(BigNumber(s_val->value)); }
-            catch (const std::invalid_argument&) { throw RuntimeError(line, fmt(Msg::STR_TO_NUM, s_val->value)); }
+            catch (const std::invalid_argument&) { throw RuntimeError(line, Msg::STR_TO_NUM, {s_val->value}); }
         } else if (auto b_val = dynamic_cast<BinaryValue*>(val.get())) { val = std::make_shared<NumberValue>(b_val->toBigNumber()); }
+        else if (auto f_val = dynamic_cast<F64Value*>(val.get())) {
+            try { val = std::make_shared<NumberValue>(f64_to_bignumber(f_val->value)); }
+            catch (const std::runtime_error& e) { throw RuntimeError(line, e.what()); }
+        }
         else if (dynamic_cast<NullValue*>(val.get())) { val = std::make_shared<NumberValue>(0); }
-    } else if (keyword.type == TokenType::STR) {
+    } else if (keyword == TokenType::F64) {
+        if (!dynamic_cast<F64Value*>(val.get())) val = convert_to_f64(val, line);
+    } else if (keyword == TokenType::STR) {
         val = std::make_shared<StringValue>(val->toString());
-    } else if (keyword.type == TokenType::BIN) {
-        if (auto s_val = dynamic_cast<StringValue*>(val.get())) { try { val = std::make_shared<BinaryValue>(s_val->value); } catch(...) { throw RuntimeError(line, fmt(Msg::STR_TO_BIN, s_val->value)); } }
+    } else if (keyword == TokenType::BIN) {
+        if (auto s_val = dynamic_cast<StringValue*>(val.get())) { try { val = std::make_shared<BinaryValue>(s_val->value); } catch(...) { throw RuntimeError(line, Msg::STR_TO_BIN, {s_val->value}); } }
+        else if (auto n_val = dynamic_cast<NumberValue*>(val.get())) {
+            try { val = std::make_shared<BinaryValue>(n_val->value.toBytes()); }
+            catch (const std::runtime_error& e) { throw RuntimeError(line, e.what()); }
+        }
         else if (dynamic_cast<NullValue*>(val.get())) { val = std::make_shared<BinaryValue>(std::vector<uint8_t>{0}); }
-    } else if (keyword.type == TokenType::LN) {
+    } else if (keyword == TokenType::LN) {
         if (!dynamic_cast<LnValue*>(val.get()) && !dynamic_cast<NullValue*>(val.get())) { throw RuntimeError(line, msg(Msg::LN_INIT_LN)); }
         if (dynamic_cast<NullValue*>(val.get())) { val = std::make_shared<LnValue>(std::vector<ValuePtr>{}); }
-    } else if (keyword.type == TokenType::DIM) {
+    } else if (keyword == TokenType::DIM) {
         if (!dynamic_cast<DimValue*>(val.get()) && !dynamic_cast<NullValue*>(val.get())) { throw RuntimeError(line, msg(Msg::DIM_INIT_DIM)); }
         if (dynamic_cast<NullValue*>(val.get())) { val = std::make_shared<DimValue>(); }
-    } else if (keyword.type == TokenType::ANY) {
+    } else if (keyword == TokenType::ANY) {
         // any type: keep value as-is
     }
     visitor.environment->define(name, val);
@@ -101,49 +310,129 @@ ValuePtr UsingNode::accept(Interpreter& visitor) {
     try {
         ValuePtr val = visitor.environment->get(original_name);
         visitor.environment->define(alias_name, val);
-    } catch (RuntimeError& e) { throw RuntimeError(line, e.what()); }
+    } catch (RuntimeError& e) { e.line = line; throw; }
     return std::make_shared<NullValue>();
 }
 
 ValuePtr UnaryOpNode::accept(Interpreter& visitor) {
     ValuePtr right_val = visitor.evaluate(right);
-    switch (op.type) {
+    switch (op) {
         case TokenType::MINUS: {
+            if (auto f_val = dynamic_cast<F64Value*>(right_val.get())) return std::make_shared<F64Value>(-f_val->value);
             auto zero = std::make_shared<NumberValue>(0);
             try { return zero->subtract(*right_val); }
-            catch (const std::runtime_error& e) { throw RuntimeError(op.line, e.what()); }
+            catch (const std::runtime_error& e) { throw RuntimeError(line, e.what()); }
         }
-        case TokenType::NOT: return std::make_shared<NumberValue>(right_val->isTruthy() ? 0 : 1);
-        default: throw RuntimeError(op.line, "Invalid unary operator.");
+        case TokenType::NOT: return bool_value(!right_val->isTruthy());
+        default: throw RuntimeError(line, "Invalid unary operator.");
+    }
+}
+
+bool UnaryOpNode::test(Interpreter& visitor) {
+    if (op == TokenType::NOT) return !right->test(visitor);
+    return AstNode::test(visitor);
+}
+
+bool BinaryOpNode::is_comparison() const {
+    switch (op) {
+        case TokenType::EQUAL_EQUAL: case TokenType::BANG_EQUAL:
+        case TokenType::LESS: case TokenType::LESS_EQUAL:
+        case TokenType::GREATER: case TokenType::GREATER_EQUAL: return true;
+        default: return false;
     }
 }
 
 ValuePtr BinaryOpNode::accept(Interpreter& visitor) {
     auto left_val = visitor.evaluate(left);
     auto right_val = visitor.evaluate(right);
+    return apply(left_val, right_val);
+}
+
+ValuePtr BinaryOpNode::apply(const ValuePtr& left_val, const ValuePtr& right_val) {
     try {
-        switch (op.type) {
+        // Quickened path: once a site has seen two plain numbers it calls the
+        // BigNumber operators directly; any other operand kind demotes it for good.
+        if (quickened != Quickened::GENERIC) {
+            const NumberValue* l = exact_number(left_val);
+            const NumberValue* r = l ? exact_number(right_val) : nullptr;
+            if (l && r) {
+                quickened = Quickened::NUMBERS;
+                switch (op) {
+                    case TokenType::PLUS: return std::make_shared<NumberValue>(l->value + r->value);
+                    case TokenType::MINUS: return std::make_shared<NumberValue>(l->value - r->value);
+                    case TokenType::STAR: return std::make_shared<NumberValue>(l->value * r->value);
+                    case TokenType::SLASH:
+                        if (Rational::exact_mode()) return l->divide(*r);
+                        return std::make_shared<NumberValue>(l->value / r->value);
+                    case TokenType::CARET: return std::make_shared<NumberValue>(l->value ^ r->value);
+                    case TokenType::MODULO: return std::make_shared<NumberValue>(l->value % r->value);
+                    default:
+                        if (is_comparison()) return bool_value(compare_numbers(op, l->value, r->value));
+                        break;
+                }
+            } else {
+                quickened = Quickened::GENERIC;
+            }
+        }
+        // Two f64 operands never need promotion, so skip the virtual dispatch.
+        if (typeid(*left_val) == typeid(F64Value) && typeid(*right_val) == typeid(F64Value)) {
+            double l = static_cast<F64Value*>(left_val.get())->value, r = static_cast<F64Value*>(right_val.get())->value;
+            switch (op) {
+                case TokenType::PLUS: return std::make_shared<F64Value>(l + r);
+                case TokenType::MINUS: return std::make_shared<F64Value>(l - r);
+                case TokenType::STAR: return std::make_shared<F64Value>(l * r);
+                case TokenType::SLASH: return std::make_shared<F64Value>(l / r);
+                case TokenType::LESS: return bool_value(l < r);
+                case TokenType::LESS_EQUAL: return bool_value(l <= r);
+                case TokenType::GREATER: return bool_value(l > r);
+                case TokenType::GREATER_EQUAL: return bool_value(l >= r);
+                case TokenType::EQUAL_EQUAL: return bool_value(l == r);
+                case TokenType::BANG_EQUAL: return bool_value(l != r);
+                default: break;
+            }
+        }
+        switch (op) {
             case TokenType::PLUS: return left_val->add(*right_val);
             case TokenType::MINUS: return left_val->subtract(*right_val);
             case TokenType::STAR: return left_val->multiply(*right_val);
             case TokenType::SLASH: return left_val->divide(*right_val);
             case TokenType::CARET: return left_val->power(*right_val);
             case TokenType::MODULO: return left_val->modulo(*right_val);
-            case TokenType::EQUAL_EQUAL: return std::make_shared<NumberValue>(left_val->isEqualTo(*right_val) ? 1 : 0);
-            case TokenType::BANG_EQUAL: return std::make_shared<NumberValue>(!left_val->isEqualTo(*right_val) ? 1 : 0);
-            case TokenType::LESS: return std::make_shared<NumberValue>(left_val->isLessThan(*right_val) ? 1 : 0);
-            case TokenType::LESS_EQUAL: return std::make_shared<NumberValue>(!right_val->isLessThan(*left_val) ? 1 : 0);
-            case TokenType::GREATER: return std::make_shared<NumberValue>(right_val->isLessThan(*left_val) ? 1 : 0);
-            case TokenType::GREATER_EQUAL: return std::make_shared<NumberValue>(!left_val->isLessThan(*right_val) ? 1 : 0);
-            default: break;
-        }
-    } catch (const std::runtime_error& e) { throw RuntimeError(op.line, e.what()); }
+            default:
+                if (is_comparison()) return bool_value(compare_values(op, *left_val, *right_val));
+                break;
+        }
+    } catch (const std::runtime_error& e) { throw RuntimeError(line, e.what()); }
     return std::make_shared<NullValue>();
 }
 
+// Fused compare-and-branch: conditions never materialize the 0/1 result.
+bool BinaryOpNode::test(Interpreter& visitor) {
+    if (!is_comparison()) return AstNode::test(visitor);
+    auto left_val = visitor.evaluate(left);
+    auto right_val = visitor.evaluate(right);
+    try {
+        if (quickened != Quickened::GENERIC) {
+            const NumberValue* l = exact_number(left_val);
+            const NumberValue* r = l ? exact_number(right_val) : nullptr;
+            if (l && r) {
+                quickened = Quickened::NUMBERS;
+                return compare_numbers(op, l->value, r->value);
+            }
+            quickened = Quickened::GENERIC;
+        }
+        return compare_values(op, *left_val, *right_val);
+    } catch (const std::runtime_error& e) { throw RuntimeError(line, e.what()); }
+}
+
+bool LogicalOpNode::test(Interpreter& visitor) {
+    if (op == TokenType::OR) return left->test(visitor) || right->test(visitor);
+    return left->test(visitor) && right->test(visitor);
+}
+
 ValuePtr LogicalOpNode::accept(Interpreter& visitor) {
     ValuePtr left_val = visitor.evaluate(left);
-    if (op.type == TokenType::OR) {
+    if (op == TokenType::OR) {
         if (left_val->isTruthy()) return left_val;
     } else {
         if (!left_val->isTruthy()) return left_val;
@@ -153,16 +442,28 @@ ValuePtr LogicalOpNode::accept(Interpreter& visitor) {
 
 ValuePtr TypeConversionNode::accept(Interpreter& visitor) {
     ValuePtr val = visitor.evaluate(expression);
-    switch (type_keyword.type) {
+    switch (type_keyword) {
         case TokenType::DEC:
             if (dynamic_cast<NumberValue*>(val.get())) return val;
+            if (auto r_val = dynamic_cast<RationalValue*>(val.get())) return std::make_shared<NumberValue>(r_val->value.toBigNumber());
             if (auto s_val = dynamic_cast<StringValue*>(val.get())) { try { return std::make_shared<NumberValue>(BigNumber(s_val->value)); } catch (const std::invalid_argument&) { throw RuntimeError(line, std::string("Cannot convert string '") + s_val->value + "' to a number."); } }
             if (auto b_val = dynamic_cast<BinaryValue*>(val.get())) { return std::make_shared<NumberValue>(b_val->toBigNumber()); }
+            if (auto f_val = dynamic_cast<F64Value*>(val.get())) {
+                try { return std::make_shared<NumberValue>(f64_to_bignumber(f_val->value)); }
+                catch (const std::runtime_error& e) { throw RuntimeError(line, e.what()); }
+            }
             throw RuntimeError(line, "Unsupported conversion to 'dec'.");
+        case TokenType::F64:
+            if (dynamic_cast<F64Value*>(val.get())) return val;
+            return convert_to_f64(val, line);
         case TokenType::STR:
             return std::make_shared<StringValue>(val->toString());
         case TokenType::BIN:
             if (dynamic_cast<BinaryValue*>(val.get())) return val;
+            if (auto n_val = dynamic_cast<NumberValue*>(val.get())) {
+                try { return std::make_shared<BinaryValue>(n_val->value.toBytes()); }
+                catch (const std::runtime_error& e) { throw RuntimeError(line, e.what()); }
+            }
             if (auto s_val = dynamic_cast<StringValue*>(val.get())) { try { return std::make_shared<BinaryValue>(s_val->value); } catch (...) { throw RuntimeError(line, std::string("Cannot convert string '") + s_val->value + "' to binary. Expected '0x...' format."); } }
             throw RuntimeError(line, "Unsupported conversion to 'bin'.");
         case TokenType::LN:
@@ -179,18 +480,34 @@ ValuePtr TypeConversionNode::accept(Interpreter& visitor) {
 }
 
 ValuePtr SubscriptNode::accept(Interpreter& visitor) {
-    try {
-        auto object = visitor.evaluate(this->object);
-        if (!is_slice) {
-            auto index = visitor.evaluate(this->start);
-            return object->getSubscript(*index);
-        } else {
-            ValuePtr start_v = this->start ? visitor.evaluate(this->start) : std::make_shared<NullValue>();
-            ValuePtr end_v = this->end ? visitor.evaluate(this->end) : std::make_shared<NullValue>();
-            ValuePtr step_v = this->step ? visitor.evaluate(this->step) : std::make_shared<NullValue>();
-            return object->getSlice(start_v, end_v, step_v);
+    // Operands are evaluated outside the try so script raises pass through
+    // untouched; only errors from the subscript operation itself are rewrapped.
+    auto object = visitor.evaluate(this->object);
+    if (!is_slice) {
+        auto index = visitor.evaluate(this->start);
+        // Quickened `ln[number]` load: plain index arithmetic, no virtual call.
+        if (quickened != Quickened::GENERIC) {
+            const NumberValue* num = exact_number(index);
+            if (num && typeid(*object) == typeid(LnValue)) {
+                quickened = Quickened::NUMBERS;
+                const auto& elements = static_cast<LnValue*>(object.get())->elements;
+                long long i, size = elements.size();
+                if (num->value.toSmallInt(i)) {
+                    if (i < 0) i += size;
+                    if (i >= 0 && i < size) return elements[i];
+                }
+            } else {
+                quickened = Quickened::GENERIC;
+            }
         }
-    } catch (const std::runtime_error& e) { throw RuntimeError(line, e.what()); }
+        try { return object->getSubscript(*index); }
+        catch (const std::runtime_error& e) { throw RuntimeError(line, e.what()); }
+    }
+    ValuePtr start_v = this->start ? visitor.evaluate(this->start) : std::make_shared<NullValue>();
+    ValuePtr end_v = this->end ? visitor.evaluate(this->end) : std::make_shared<NullValue>();
+    ValuePtr step_v = this->step ? visitor.evaluate(this->step) : std::make_shared<NullValue>();
+    try { return object->getSlice(start_v, end_v, step_v); }
+    catch (const std::runtime_error& e) { throw RuntimeError(line, e.what()); }
 }
 
 ValuePtr ClassDefNode::accept(Interpreter& visitor) {
@@ -200,6 +517,7 @@ ValuePtr ClassDefNode::accept(Interpreter& visitor) {
         if (func_def_node) {
             auto method_func = std::make_shared<Function>(
                 func_def_node->name, func_def_node->params, func_def_node->body, visitor.environment);
+            method_func->lazy_body = func_def_node->lazy_body;
             methods_map[func_def_node->name] = method_func;
         }
     }
@@ -212,14 +530,14 @@ ValuePtr GetNode::accept(Interpreter& visitor) {
     auto object_val = visitor.evaluate(object);
     if (auto instance = std::dynamic_pointer_cast<Instance>(object_val)) {
         try { return instance->get(name); }
-        catch (const std::runtime_error& e) { throw RuntimeError(line, e.what()); }
+        catch (RuntimeError& e) { e.line = line; throw; }
     }
     if (auto dim_val = std::dynamic_pointer_cast<DimValue>(object_val)) {
         auto key = std::make_shared<StringValue>(name);
         try { return dim_val->getSubscript(*key); }
         catch (const std::runtime_error& e) { throw RuntimeError(line, e.what()); }
     }
-    throw RuntimeError(line, fmt(Msg::NO_PROP, name));
+    throw RuntimeError(line, Msg::NO_PROP, {name});
 }
 
 ValuePtr SetNode::accept(Interpreter& visitor) {
@@ -261,8 +579,7 @@ ValuePtr RequireNode::accept(Interpreter& visitor) {
 
 ValuePtr IfStatementNode::accept(Interpreter& visitor) {
     visitor.check_timeout(line);
-    auto condition_val = visitor.evaluate(condition);
-    if (condition_val->isTruthy()) {
+    if (condition->test(visitor)) {
         visitor.execute_block(then_branch, std::make_shared<Environment>(visitor.environment));
     } else if (!else_branch.empty()) {
         visitor.execute_block(else_branch, std::make_shared<Environment>(visitor.environment));
@@ -271,9 +588,9 @@ ValuePtr IfStatementNode::accept(Interpreter& visitor) {
 }
 
 ValuePtr WhileStatementNode::accept(Interpreter& visitor) {
-    while (true) {
-        auto condition_val = visitor.evaluate(condition);
-        if (!condition_val->isTruthy()) break;
+    bool finished = step && run_counted(visitor);
+    while (!finished) {
+        if (!condition->test(visitor)) break;
         visitor.check_timeout(line);
         try { visitor.execute_block(do_branch, std::make_shared<Environment>(visitor.environment)); }
         catch (const BreakException&) { break; }
@@ -285,8 +602,61 @@ ValuePtr WhileStatementNode::accept(Interpreter& visitor) {
     return std::make_shared<NullValue>();
 }
 
+// Counted loop: the counter lives in a machine integer and is written back into
+// its own NumberValue each step, boxing a fresh one only when something else
+// holds a reference. Returns false once the counter or the bound stops being a
+// small integer, or the body assigns the counter; the generic loop then
+// resumes from the same state.
+bool WhileStatementNode::run_counted(Interpreter& visitor) {
+    static const long long LIMIT = 100000000000000LL; // Well inside toSmallInt's range
+    ValuePtr* slot = visitor.environment->find_slot(counter);
+    const NumberValue* start = slot ? exact_number(*slot) : nullptr;
+    long long k;
+    if (!start || !start->value.toSmallInt(k)) return false;
+    ValuePtr box = *slot;
+    auto cmp = static_cast<BinaryOpNode*>(condition.get());
+    while (true) {
+        ValuePtr bound_val = visitor.evaluate(cmp->right);
+        const NumberValue* bound_num = exact_number(bound_val);
+        long long bound;
+        if (!bound_num || !bound_num->value.toSmallInt(bound)) return false;
+        bool go;
+        switch (cmp->op) {
+            case TokenType::LESS: go = k < bound; break;
+            case TokenType::LESS_EQUAL: go = k <= bound; break;
+            case TokenType::GREATER: go = k > bound; break;
+            case TokenType::GREATER_EQUAL: go = k >= bound; break;
+            default: go = k != bound; break;
+        }
+        if (!go) return true;
+        visitor.check_timeout(line);
+        try { visitor.execute_block(counted_body, std::make_shared<Environment>(visitor.environment)); }
+        catch (const BreakException&) { return true; }
+        catch (const ContinueException&) { if (slot->get() != box.get()) return false; continue; }
+        if (slot->get() != box.get() || k + step >= LIMIT || k + step <= -LIMIT) {
+            visitor.execute_block({do_branch.back()}, std::make_shared<Environment>(visitor.environment));
+            return false;
+        }
+        k += step;
+        if (box.use_count() == 2) static_cast<NumberValue*>(box.get())->value.assignSmallInt(k);
+        else { box = std::make_shared<NumberValue>(BigNumber(k)); *slot = box; }
+    }
+}
+
 ValuePtr ForInNode::accept(Interpreter& visitor) {
     ValuePtr iter_val = visitor.evaluate(iterable);
+    if (auto table = std::dynamic_pointer_cast<TableValue>(iter_val)) {
+        for (size_t i = 0; i < table->rows; ++i) {
+            visitor.check_timeout(line);
+            try {
+                auto block_env = std::make_shared<Environment>(visitor.environment);
+                block_env->define(var_name, std::make_shared<RowValue>(table, i));
+                visitor.execute_block(body, block_env);
+            } catch (const BreakException&) { break; }
+            catch (const ContinueException&) { continue; }
+        }
+        return std::make_shared<NullValue>();
+    }
     LnValue* ln_val = dynamic_cast<LnValue*>(iter_val.get());
     if (!ln_val) throw RuntimeError(line, "for-in requires an ln (list) value.");
     
@@ -315,7 +685,7 @@ ValuePtr LoopForNode::accept(Interpreter& visitor) {
         try {
             auto block_env = std::make_shared<Environment>(visitor.environment);
             if (!index_var_name.empty()) {
-                block_env->define(index_var_name, std::make_shared<NumberValue>(BigNumber(std::to_string(i))));
+                block_env->define(index_var_name, std::make_shared<NumberValue>(BigNumber(i)));
             }
             visitor.execute_block(body, block_env);
         } catch (const BreakException&) { break; }
@@ -330,15 +700,14 @@ ValuePtr LoopUntilNode::accept(Interpreter& visitor) {
         visitor.check_timeout(line);
         auto block_env = std::make_shared<Environment>(visitor.environment);
         if (!index_var_name.empty()) {
-            block_env->define(index_var_name, std::make_shared<NumberValue>(BigNumber(std::to_string(i++))));
+            block_env->define(index_var_name, std::make_shared<NumberValue>(BigNumber(i++)));
         }
         std::shared_ptr<Environment> previous = visitor.environment;
         try {
             visitor.environment = block_env;
             for (const auto& stmt : body) { visitor.execute(stmt); }
             if (condition) {
-                ValuePtr condition_val = visitor.evaluate(condition);
-                if (condition_val->isTruthy()) { visitor.environment = previous; break; }
+                if (condition->test(visitor)) { visitor.environment = previous; break; }
             }
             visitor.environment = previous;
         } catch (const BreakException&) { visitor.environment = previous; break; }
@@ -352,7 +721,7 @@ ValuePtr BreakNode::accept(Interpreter& visitor) { throw BreakException(); }
 ValuePtr ContinueNode::accept(Interpreter& visitor) { throw ContinueException(); }
 
 ValuePtr AwaitStatementNode::accept(Interpreter& visitor) {
-    while (!visitor.evaluate(condition)->isTruthy()) {
+    while (!condition->test(visitor)) {
         visitor.check_timeout(line);
         std::this_thread::sleep_for(std::chrono::milliseconds(20));
     }
@@ -362,7 +731,8 @@ ValuePtr AwaitStatementNode::accept(Interpreter& visitor) {
 
 ValuePtr SayNode::accept(Interpreter& visitor) {
     auto val = visitor.evaluate(expression);
-    std::cout << val->toString() << std::endl;
+    if (typeid(*val) == typeid(StringValue)) std::cout << static_cast<StringValue*>(val.get())->value << std::endl;
+    else std::cout << val->toString() << std::endl;
     return std::make_shared<NullValue>();
 }
 
@@ -376,6 +746,8 @@ ValuePtr InpNode::accept(Interpreter& visitor) {
 
 ValuePtr FnDefNode::accept(Interpreter& visitor) {
     auto function = std::make_shared<Function>(name, params, body, visitor.environment);
+    function->lazy_body = lazy_body;
+    if (is_memo) function->memo = std::make_shared<MemoCache>(MemoCache::DEFAULT_CAPACITY);
     visitor.environment->define(name, std::make_shared<FunctionValue>(function));
     return std::make_shared<NullValue>();
 }
@@ -392,7 +764,12 @@ ValuePtr CallNode::accept(Interpreter& visitor) {
             ValuePtr result = native_fn->call(arg_values);
             visitor.call_stack.pop_back();
             return result;
-        } catch (const RuntimeError& re) {
+        } catch (RuntimeError& re) {
+            visitor.call_stack.pop_back();
+            if (!re.line) re.line = line;
+            throw;
+        } catch (const PyRiteRaiseException&) {
+            // Raised by a script callback; the payload must reach `catch` untouched.
             visitor.call_stack.pop_back();
             throw;
         } catch (const std::exception& e) {
@@ -401,112 +778,134 @@ ValuePtr CallNode::accept(Interpreter& visitor) {
         }
     }
 
-    // Bound method call
-    if (auto bound_method = dynamic_cast<BoundMethodValue*>(callee_val.get())) {
-        auto function = bound_method->method;
-        auto call_env = std::make_shared<Environment>(function->closure);
-        call_env->define("this", bound_method->instance);
-
-        const auto& param_defs = function->params;
-        size_t num_provided_args = arg_values.size();
-        size_t num_required_params = 0;
-        for (const auto& p : param_defs) { if (!p.has_default) num_required_params++; }
-
-        if (num_provided_args < num_required_params) {
-            std::stringstream ss;
-            ss << "Method '" << function->name << fmt_int(Msg::ARGS_AT_LEAST, num_required_params) << num_provided_args << ".";
-            throw RuntimeError(line, ss.str());
-        }
-        if (num_provided_args > param_defs.size()) {
-            std::stringstream ss;
-            ss << "Method '" << function->name << fmt_int(Msg::ARGS_AT_MOST, param_defs.size()) << num_provided_args << ".";
-            throw RuntimeError(line, ss.str());
-        }
-
-        for (size_t i = 0; i < function->params.size(); ++i) {
-            ValuePtr current_arg_value;
-            if (i < num_provided_args) { current_arg_value = arg_values[i]; }
-            else if (param_defs[i].default_expr) { current_arg_value = visitor.evaluate(param_defs[i].default_expr); }
-            else { current_arg_value = param_defs[i].default_value->clone(); }
-            if (!is_type_compatible(param_defs[i].type_keyword, current_arg_value)) {
-                std::stringstream ss;
-                ss << fmt3(Msg::ARG_TYPE, std::to_string(i + 1), function->name, param_defs[i].name)
-                   << "期望 " << token_type_to_string(param_defs[i].type_keyword) << ", 得到 ";
-                if (dynamic_cast<NumberValue*>(current_arg_value.get())) ss << "dec";
-                else if (dynamic_cast<StringValue*>(current_arg_value.get())) ss << "str";
-                else if (dynamic_cast<BinaryValue*>(current_arg_value.get())) ss << "bin";
-                else if (dynamic_cast<LnValue*>(current_arg_value.get())) ss << "ln";
-                else if (dynamic_cast<DimValue*>(current_arg_value.get())) ss << "dim";
-                else ss << "unknown";
-                ss << "。";
-                throw RuntimeError(line, ss.str());
-            }
-            call_env->define(param_defs[i].name, current_arg_value);
-        }
-
-        visitor.call_stack.push_back({function->name, line});
-        ValuePtr return_val = std::make_shared<NullValue>();
-        try { visitor.execute_block(function->body, call_env); }
-        catch (const ReturnValueException& rv) { return_val = rv.value; }
-        visitor.call_stack.pop_back();
-        return return_val;
-    }
-
-    // Regular function call
-    if (auto func_val = dynamic_cast<FunctionValue*>(callee_val.get())) {
-        auto function = func_val->value;
-        auto call_env = std::make_shared<Environment>(function->closure);
-
-        const auto& param_defs = function->params;
-        size_t num_provided_args = arg_values.size();
-        size_t num_required_params = 0;
-        for (const auto& p : param_defs) { if (!p.has_default) num_required_params++; }
-
-        if (num_provided_args < num_required_params) {
-            std::stringstream ss;
-            ss << "Function '" << function->name << fmt_int(Msg::ARGS_AT_LEAST, num_required_params) << num_provided_args << ".";
-            throw RuntimeError(line, ss.str());
-        }
-        if (num_provided_args > param_defs.size()) {
-            std::stringstream ss;
-            ss << "Function '" << function->name << fmt_int(Msg::ARGS_AT_MOST, param_defs.size()) << num_provided_args << ".";
-            throw RuntimeError(line, ss.str());
-        }
-
-        for (size_t i = 0; i < function->params.size(); ++i) {
-            ValuePtr current_arg_value;
-            if (i < num_provided_args) { current_arg_value = arg_values[i]; }
-            else if (param_defs[i].default_expr) { current_arg_value = visitor.evaluate(param_defs[i].default_expr); }
-            else { current_arg_value = param_defs[i].default_value->clone(); }
-            if (!is_type_compatible(param_defs[i].type_keyword, current_arg_value)) {
-                std::stringstream ss;
-                ss << fmt3(Msg::ARG_TYPE, std::to_string(i + 1), function->name, param_defs[i].name)
-                   << "期望 " << token_type_to_string(param_defs[i].type_keyword) << ", 得到 ";
-                if (dynamic_cast<NumberValue*>(current_arg_value.get())) ss << "dec";
-                else if (dynamic_cast<StringValue*>(current_arg_value.get())) ss << "str";
-                else if (dynamic_cast<BinaryValue*>(current_arg_value.get())) ss << "bin";
-                else if (dynamic_cast<LnValue*>(current_arg_value.get())) ss << "ln";
-                else if (dynamic_cast<DimValue*>(current_arg_value.get())) ss << "dim";
-                else ss << "unknown";
-                ss << "。";
-                throw RuntimeError(line, ss.str());
-            }
-            call_env->define(param_defs[i].name, current_arg_value);
+    if (auto bound_method = dynamic_cast<BoundMethodValue*>(callee_val.get()))
+        return visitor.call_function(bound_method->method, arg_values, line, bound_method->instance);
+    if (auto func_val = dynamic_cast<FunctionValue*>(callee_val.get()))
+        return visitor.call_function(func_val->value, arg_values, line);
+
+    throw RuntimeError(line, Msg::CALL_ONLY, {callee_val->repr()});
+}
+
+static uint64_t structural_hash(const Value* val);
+
+// Body of `function`, parsing it first if it was skipped by a lazy module parse.
+// The parsed body is shared by every function made from the same definition.
+const std::vector<AstNodePtr>& Interpreter::body_of(Function& function) {
+    if (function.lazy_body) {
+        LazyBody& lazy = *function.lazy_body;
+        if (!lazy.parsed) {
+            int error_line = lazy.line;
+            std::shared_ptr<AstArena> arena;
+            try { lazy.body = Parser::parse_body(lazy.source, lazy.line, error_line, arena); }
+            catch (const std::runtime_error& e) { throw RuntimeError(error_line, e.what()); }
+            keep_arena(arena);
+            lazy.parsed = true;
+            std::string().swap(lazy.source);
+        }
+        function.body = lazy.body;
+        function.lazy_body.reset();
+    }
+    return function.body;
+}
+
+// Binds arguments in a fresh scope and runs the body. A memoized function is
+// answered from its cache before that scope is created. `instance` is bound
+// to `this` for method calls.
+ValuePtr Interpreter::call_function(const std::shared_ptr<Function>& function, const std::vector<ValuePtr>& arg_values, int line, const InstancePtr& instance) {
+    MemoCache* memo = instance ? nullptr : function->memo.get();
+    uint64_t memo_key = 0;
+    if (memo) {
+        memo_key = Hash::xxhash64(nullptr, 0, arg_values.size());
+        for (const auto& arg : arg_values) memo_key = Hash::combine(memo_key, structural_hash(arg.get()));
+        ValuePtr cached;
+        if (memo->lookup(memo_key, arg_values, cached)) return cached;
+    }
+
+    auto call_env = std::make_shared<Environment>(function->closure);
+    if (instance) call_env->define("this", instance);
+    const char* kind = instance ? "Method '" : "Function '";
+
+    const auto& param_defs = function->params;
+    size_t num_provided_args = arg_values.size();
+    size_t num_required_params = 0;
+    for (const auto& p : param_defs) { if (!p.has_default) num_required_params++; }
+
+    if (num_provided_args < num_required_params) {
+        std::stringstream ss;
+        ss << kind << function->name << fmt_int(Msg::ARGS_AT_LEAST, num_required_params) << num_provided_args << ".";
+        throw RuntimeError(line, ss.str());
+    }
+    if (num_provided_args > param_defs.size()) {
+        std::stringstream ss;
+        ss << kind << function->name << fmt_int(Msg::ARGS_AT_MOST, param_defs.size()) << num_provided_args << ".";
+        throw RuntimeError(line, ss.str());
+    }
+
+    for (size_t i = 0; i < function->params.size(); ++i) {
+        ValuePtr current_arg_value;
+        if (i < num_provided_args) { current_arg_value = arg_values[i]; }
+        else if (param_defs[i].default_expr) { current_arg_value = evaluate(param_defs[i].default_expr); }
+        else { current_arg_value = copy_value(param_defs[i].default_value); }
+        current_arg_value = promote_to_declared(param_defs[i].type_keyword, current_arg_value);
+        if (!is_type_compatible(param_defs[i].type_keyword, current_arg_value)) {
+            throw RuntimeError(line, Msg::ARG_TYPE, {std::to_string(i + 1), function->name, param_defs[i].name,
+                token_type_to_string(param_defs[i].type_keyword), value_type_to_string(current_arg_value)});
         }
+        call_env->define(param_defs[i].name, current_arg_value);
+    }
+
+    call_stack.push_back({function->name, line});
+    ValuePtr return_val = NullValue::instance();
+    try { execute_block(body_of(*function), call_env); }
+    catch (const ReturnValueException& rv) { return_val = rv.value; }
+    call_stack.pop_back();
+    if (memo) memo->store(memo_key, arg_values, return_val);
+    return return_val;
+}
 
-        visitor.call_stack.push_back({function->name, line});
-        ValuePtr return_val = std::make_shared<NullValue>();
-        try { visitor.execute_block(function->body, call_env); }
-        catch (const ReturnValueException& rv) { return_val = rv.value; }
-        visitor.call_stack.pop_back();
-        return return_val;
+ValuePtr InlineArgNode::accept(Interpreter& visitor) {
+    return visitor.inline_args[index];
+}
+
+// Same argument checks as call_function, then the body expression is evaluated
+// directly: no scope, no frame and no ReturnValueException. A frame is pushed
+// only if the body throws, so traces read as if the call had been made.
+ValuePtr InlinedCallNode::accept(Interpreter& visitor) {
+    visitor.check_timeout(line);
+    ValuePtr callee_val = visitor.evaluate(call->callee);
+    auto fn_val = dynamic_cast<FunctionValue*>(callee_val.get());
+    if (!fn_val || fn_val->value->memo || fn_val->value->body.size() != 1 || fn_val->value->body[0] != origin)
+        return call->accept(visitor);
+    const Function& function = *fn_val->value;
+
+    ValuePtr args[MAX_ARGS];
+    size_t provided = call->arguments.size();
+    for (size_t i = 0; i < provided; ++i) args[i] = visitor.evaluate(call->arguments[i]);
+    for (size_t i = 0; i < function.params.size(); ++i) {
+        const ParameterDefinition& param = function.params[i];
+        ValuePtr value = promote_to_declared(param.type_keyword, i < provided ? args[i] : copy_value(param.default_value));
+        if (!is_type_compatible(param.type_keyword, value)) {
+            throw RuntimeError(line, Msg::ARG_TYPE, {std::to_string(i + 1), function.name, param.name,
+                token_type_to_string(param.type_keyword), value_type_to_string(value)});
+        }
+        args[i] = value;
     }
 
-    throw RuntimeError(line, fmt(Msg::CALL_ONLY, callee_val->repr()));
+    const ValuePtr* outer_args = visitor.inline_args;
+    visitor.inline_args = args;
+    try {
+        ValuePtr result = visitor.evaluate(body);
+        visitor.inline_args = outer_args;
+        return result;
+    } catch (...) {
+        visitor.inline_args = outer_args;
+        visitor.call_stack.push_back({function.name, line});
+        throw;
+    }
 }
 
 ValuePtr ReturnNode::accept(Interpreter& visitor) {
-    ValuePtr val = std::make_shared<NullValue>();
+    ValuePtr val = NullValue::instance();
     if (value) { val = visitor.evaluate(value); }
     throw ReturnValueException(val);
 }
@@ -516,27 +915,34 @@ ValuePtr RaiseNode::accept(Interpreter& visitor) {
 }
 
 ValuePtr TryCatchNode::accept(Interpreter& visitor) {
-    std::unique_ptr<std::exception_ptr> captured_exception = nullptr;
+    // Entering the block costs nothing beyond the C++ try itself: no scope is
+    // created unless the block declares names, and nothing is allocated until
+    // an exception actually escapes.
+    std::exception_ptr pending;
+    size_t depth = visitor.call_stack.size();
     try {
         try {
-            visitor.execute_block(try_branch, std::make_shared<Environment>(visitor.environment));
+            visitor.execute_block(try_branch, try_scoped ? std::make_shared<Environment>(visitor.environment) : visitor.environment);
         } catch (const PyRiteRaiseException& ex) {
+            // Frames abandoned by the throw are only kept for uncaught traces.
+            visitor.call_stack.erase(visitor.call_stack.begin() + depth, visitor.call_stack.end());
             auto catch_env = std::make_shared<Environment>(visitor.environment);
             catch_env->define(exception_var, ex.value);
             visitor.execute_block(catch_branch, catch_env);
         } catch (const RuntimeError& ex) {
+            visitor.call_stack.erase(visitor.call_stack.begin() + depth, visitor.call_stack.end());
             auto exception_obj = std::make_shared<ExceptionValue>(std::make_shared<StringValue>(ex.what()));
             auto catch_env = std::make_shared<Environment>(visitor.environment);
             catch_env->define(exception_var, exception_obj);
             visitor.execute_block(catch_branch, catch_env);
         }
     } catch (...) {
-        captured_exception.reset(new std::exception_ptr(std::current_exception()));
+        pending = std::current_exception();
     }
     if (!finally_branch.empty()) {
-        visitor.execute_block(finally_branch, std::make_shared<Environment>(visitor.environment));
+        visitor.execute_block(finally_branch, finally_scoped ? std::make_shared<Environment>(visitor.environment) : visitor.environment);
     }
-    if (captured_exception) { std::rethrow_exception(*captured_exception); }
+    if (pending) std::rethrow_exception(pending);
     return std::make_shared<NullValue>();
 }
 
@@ -580,19 +986,24 @@ ValuePtr Interpreter::evaluate(const AstNodePtr& expr) {
     return expr->accept(*this);
 }
 
+namespace {
+// Restores the current scope on every exit path. Using a destructor instead of
+// catch-and-rethrow lets exceptions unwind through nested blocks in a single
+// pass rather than restarting the handler search at every level.
+struct ScopeRestorer {
+    std::shared_ptr<Environment>& current;
+    std::shared_ptr<Environment> previous;
+    ~ScopeRestorer() { current = previous; }
+};
+}
+
 void Interpreter::execute_block(const std::vector<AstNodePtr>& statements, std::shared_ptr<Environment> block_env) {
-    std::shared_ptr<Environment> previous = this->environment;
-    try {
-        this->environment = block_env;
-        for (const auto& stmt : statements) {
-            check_timeout(stmt->line);
-            execute(stmt);
-        }
-    } catch (...) {
-        this->environment = previous;
-        throw;
+    ScopeRestorer restore{this->environment, this->environment};
+    this->environment = block_env;
+    for (const auto& stmt : statements) {
+        check_timeout(stmt->line);
+        execute(stmt);
     }
-    this->environment = previous;
 }
 
 void Interpreter::check_timeout(int line) {
@@ -608,20 +1019,20 @@ void Interpreter::check_timeout(int line) {
 void Interpreter::assignToLValue(AstNodePtr target, ValuePtr val, int line) {
     if (auto var_node = dynamic_cast<VariableNode*>(target.get())) {
         try { this->environment->assign(var_node->name, val); }
-        catch (RuntimeError& e) { throw RuntimeError(line, e.what()); }
+        catch (RuntimeError& e) { e.line = line; throw; }
     } else if (auto sub_node = dynamic_cast<SubscriptNode*>(target.get())) {
-        try {
-            auto object = this->evaluate(sub_node->object);
-            if (!sub_node->is_slice) {
-                auto index = this->evaluate(sub_node->start);
-                object->setSubscript(*index, val);
-            } else {
-                ValuePtr start_v = sub_node->start ? this->evaluate(sub_node->start) : std::make_shared<NullValue>();
-                ValuePtr end_v = sub_node->end ? this->evaluate(sub_node->end) : std::make_shared<NullValue>();
-                ValuePtr step_v = sub_node->step ? this->evaluate(sub_node->step) : std::make_shared<NullValue>();
-                object->setSlice(start_v, end_v, step_v, val);
-            }
-        } catch (const std::runtime_error& e) { throw RuntimeError(line, e.what()); }
+        auto object = this->evaluate(sub_node->object);
+        if (!sub_node->is_slice) {
+            auto index = this->evaluate(sub_node->start);
+            try { object->setSubscript(*index, val); }
+            catch (const std::runtime_error& e) { throw RuntimeError(line, e.what()); }
+        } else {
+            ValuePtr start_v = sub_node->start ? this->evaluate(sub_node->start) : std::make_shared<NullValue>();
+            ValuePtr end_v = sub_node->end ? this->evaluate(sub_node->end) : std::make_shared<NullValue>();
+            ValuePtr step_v = sub_node->step ? this->evaluate(sub_node->step) : std::make_shared<NullValue>();
+            try { object->setSlice(start_v, end_v, step_v, val); }
+            catch (const std::runtime_error& e) { throw RuntimeError(line, e.what()); }
+        }
     } else {
         throw RuntimeError(line, msg(Msg::INVALID_ASSIGN));
     }
@@ -671,8 +1082,9 @@ ValuePtr Interpreter::load_module(ModuleProxy* proxy) {
 
     bool is_dir_module = (resolved.find("_index.pr") != std::string::npos);
 
-    Parser parser(source_code);
+    Parser parser(source_code, true);
     auto statements = parser.parse();
+    keep_arena(parser.node_arena());
     if (parser.has_error()) {
         loading_modules.erase(proxy->file_path);
         throw RuntimeError(0, "Parse error in module '" + proxy->file_path + "'.");
@@ -715,16 +1127,15 @@ ValuePtr Interpreter::load_module(ModuleProxy* proxy) {
 
     auto module_dict = std::make_shared<DimValue>(exports);
 
-    try {
-        ValuePtr on_req = module_env->get("_on_load");
-        if (auto fn_val = dynamic_cast<FunctionValue*>(on_req.get())) {
-            auto call_env = std::make_shared<Environment>(fn_val->value->closure);
-            call_stack.push_back({"_on_load", 0});
-            try { execute_block(fn_val->value->body, call_env); }
-            catch (const ReturnValueException&) {}
-            call_stack.pop_back();
-        }
-    } catch (const RuntimeError&) {}
+    ValuePtr on_req = module_env->try_get("_on_load");
+    if (auto fn_val = dynamic_cast<FunctionValue*>(on_req.get())) {
+        auto call_env = std::make_shared<Environment>(fn_val->value->closure);
+        call_stack.push_back({"_on_load", 0});
+        try { execute_block(body_of(*fn_val->value), call_env); }
+        catch (const ReturnValueException&) {}
+        catch (const RuntimeError&) {}
+        call_stack.pop_back();
+    }
 
     proxy->loaded = true;
     loading_modules.erase(proxy->file_path);
@@ -732,35 +1143,521 @@ ValuePtr Interpreter::load_module(ModuleProxy* proxy) {
 }
 
 // ===== Native function definitions =====
+// Natives work on plain decs; an exact fraction is rendered at the current precision.
+static std::shared_ptr<NumberValue> number_arg(const ValuePtr& val) {
+    if (auto r_val = dynamic_cast<RationalValue*>(val.get())) return std::make_shared<NumberValue>(r_val->value.toBigNumber());
+    return std::dynamic_pointer_cast<NumberValue>(val);
+}
+
+// Argument of the combinatorics natives: a non-negative integer that fits a long long.
+static long long count_arg(const ValuePtr& val) {
+    auto n_val = number_arg(val);
+    if (!n_val) throw std::runtime_error(msg(Msg::NATIVE_NUM));
+    if (!n_val->value.isInteger() || n_val->value.isNegative()) throw std::runtime_error(msg(Msg::NATIVE_COUNT));
+    return n_val->value.toLongLong();
+}
+
+// Caps on the combinatorics natives, so a huge argument is an error rather
+// than minutes of work: at most a million factors for factorial(), perm()
+// and binomial() (n! ~ 5.6 million digits), and F(n) ~ 10 million digits.
+static const long long MAX_FACTORS = 1000000;
+static const long long MAX_FIB = 50000000;
+
+static long long count_arg(const ValuePtr& val, long long max) {
+    long long n = count_arg(val);
+    if (n > max) throw std::runtime_error(msg(Msg::NATIVE_TOO_LARGE));
+    return n;
+}
+
+static const StringValue& string_value(const ValuePtr& val) {
+    auto str_val = dynamic_cast<StringValue*>(val.get());
+    if (!str_val) throw std::runtime_error(msg(Msg::NATIVE_STR));
+    return *str_val;
+}
+
+static const std::string& string_arg(const ValuePtr& val) { return string_value(val).value; }
+
+// Separator or search pattern of split/replace/count, which must not be empty.
+static const std::string& pattern_arg(const ValuePtr& val) {
+    const std::string& pattern = string_arg(val);
+    if (pattern.empty()) throw std::runtime_error(msg(Msg::NATIVE_EMPTY_PATTERN));
+    return pattern;
+}
+
+static ValuePtr string_list(const std::vector<std::string>& parts) {
+    std::vector<ValuePtr> elements;
+    elements.reserve(parts.size());
+    for (const auto& part : parts) elements.push_back(std::make_shared<StringValue>(part));
+    return std::make_shared<LnValue>(elements);
+}
+
+// Integer bounds [lo, hi] for randint and random_ln.
+static void random_bounds(const ValuePtr& a, const ValuePtr& b, BigNumber& lo, BigNumber& hi) {
+    auto a_val = number_arg(a);
+    auto b_val = number_arg(b);
+    if (!a_val || !b_val) throw std::runtime_error(msg(Msg::NATIVE_NUM));
+    lo = a_val->value;
+    hi = b_val->value;
+    if (!lo.isInteger() || !hi.isInteger() || hi < lo) throw std::runtime_error(msg(Msg::NATIVE_RAND_RANGE));
+}
+
+static bool is_numeric(const Value* v) {
+    return dynamic_cast<const NumberValue*>(v) || dynamic_cast<const F64Value*>(v) || dynamic_cast<const RationalValue*>(v);
+}
+
+// Raw bytes of a hash input. Strings and bins are read in place; anything
+// else is hashed through its string form, kept alive in `holder`.
+static void hash_input(const ValuePtr& val, const uint8_t*& data, size_t& len, std::string& holder) {
+    if (auto s_val = dynamic_cast<StringValue*>(val.get())) {
+        data = reinterpret_cast<const uint8_t*>(s_val->value.data());
+        len = s_val->value.size();
+    } else if (auto b_val = dynamic_cast<BinaryValue*>(val.get())) {
+        data = b_val->value.data();
+        len = b_val->value.size();
+    } else {
+        holder = val->toString();
+        data = reinterpret_cast<const uint8_t*>(holder.data());
+        len = holder.size();
+    }
+}
+
+static ValuePtr unsigned_value(uint64_t h) {
+    return std::make_shared<NumberValue>(BigNumber(std::to_string(h)));
+}
+
+// Hash that agrees with ==: 1 and 1.0 hash alike, ln and dim hash by content.
+static uint64_t structural_hash(const Value* val) {
+    if (auto l_val = dynamic_cast<const LnValue*>(val)) {
+        uint64_t h = Hash::xxhash64(nullptr, 0, 'l');
+        for (const auto& elem : l_val->elements) h = Hash::combine(h, structural_hash(elem.get()));
+        return h;
+    }
+    if (auto d_val = dynamic_cast<const DimValue*>(val)) {
+        uint64_t h = Hash::xxhash64(nullptr, 0, 'd');
+        for (const auto& entry : d_val->dict) {
+            h = Hash::combine(h, Hash::xxhash64(reinterpret_cast<const uint8_t*>(entry.first.data()), entry.first.size()));
+            h = Hash::combine(h, structural_hash(entry.second.get()));
+        }
+        return h;
+    }
+    if (auto b_val = dynamic_cast<const BinaryValue*>(val)) return Hash::xxhash64(b_val->value.data(), b_val->value.size(), 'b');
+    std::string text = val->toString();
+    uint64_t tag = 's';
+    if (is_numeric(val)) {
+        tag = 'n';
+        if (text.find('.') != std::string::npos && text.find('e') == std::string::npos) {
+            text.erase(text.find_last_not_of('0') + 1);
+            if (text.back() == '.') text.pop_back();
+        }
+    } else if (!dynamic_cast<const StringValue*>(val)) {
+        tag = 'o';
+    }
+    return Hash::xxhash64(reinterpret_cast<const uint8_t*>(text.data()), text.size(), tag);
+}
+
+// Gathers the decs of an ln for sum/prod/mean/dot. Returns false when an f64
+// or exact fraction is present, in which case the caller folds with the
+// ordinary operators instead.
+static bool collect_decs(const LnValue* list, std::vector<const BigNumber*>& out) {
+    out.reserve(list->elements.size());
+    for (const auto& elem : list->elements) {
+        if (auto n_val = dynamic_cast<NumberValue*>(elem.get())) { out.push_back(&n_val->value); continue; }
+        if (!is_numeric(elem.get())) throw std::runtime_error(msg(Msg::NATIVE_NUM));
+        return false;
+    }
+    return true;
+}
+
+static ValuePtr fold_numbers(const LnValue* list, ValuePtr acc, bool multiply) {
+    for (const auto& elem : list->elements) {
+        if (!is_numeric(elem.get())) throw std::runtime_error(msg(Msg::NATIVE_NUM));
+        acc = multiply ? acc->multiply(*elem) : acc->add(*elem);
+    }
+    return acc;
+}
+
+static ValuePtr sum_of(const LnValue* list) {
+    std::vector<const BigNumber*> decs;
+    if (collect_decs(list, decs)) return std::make_shared<NumberValue>(BigNumber::sum(decs));
+    return fold_numbers(list, std::make_shared<NumberValue>(BigNumber(0)), false);
+}
+
+// The column of `table` named by a str argument.
+static const TableValue::Column& table_column(const TableValue* table, const ValuePtr& name_val) {
+    auto name = dynamic_cast<StringValue*>(name_val.get());
+    if (!name) throw std::runtime_error(msg(Msg::NATIVE_STR));
+    int col = table->column_index(name->value);
+    if (col < 0) throw std::runtime_error(fmt(Msg::UNDEF_PROP, name->value));
+    return table->columns[col];
+}
+
+// dec and f64 columns are summed where they are stored, without boxing.
+static ValuePtr column_sum(const TableValue* table, const ValuePtr& name_val) {
+    const TableValue::Column& column = table_column(table, name_val);
+    if (column.unboxed() && std::find(column.present.begin(), column.present.end(), 0) != column.present.end())
+        throw std::runtime_error(msg(Msg::NATIVE_NUM));
+    if (column.type == TokenType::DEC) {
+        std::vector<const BigNumber*> decs;
+        decs.reserve(column.decs.size());
+        for (const BigNumber& d : column.decs) decs.push_back(&d);
+        return std::make_shared<NumberValue>(BigNumber::sum(decs));
+    }
+    if (column.type == TokenType::F64) {
+        double total = 0;
+        for (double d : column.f64s) total += d;
+        return std::make_shared<F64Value>(total);
+    }
+    LnValue values(column.values);
+    return sum_of(&values);
+}
+
 void Interpreter::define_native_functions() {
 #define REQUIRE_ARGS(name, count) if(args.size() != count) throw std::runtime_error(std::string(name) + fmt_int(Msg::NATIVE_ARGS, count));
 #define REQUIRE_MIN_ARGS(name, count) if(args.size() < count) throw std::runtime_error(std::string(name) + fmt_int(Msg::NATIVE_MIN_ARGS, count));
-#define GET_NUM(val, var_name) auto var_name = dynamic_cast<NumberValue*>(val.get()); if(!var_name) throw std::runtime_error(msg(Msg::NATIVE_NUM));
+#define GET_NUM(val, var_name) auto var_name = number_arg(val); if(!var_name) throw std::runtime_error(msg(Msg::NATIVE_NUM));
 #define GET_LN(val, var_name) auto var_name = dynamic_cast<LnValue*>(val.get()); if(!var_name) throw std::runtime_error(msg(Msg::NATIVE_LN));
+#define GET_TABLE(val, var_name) auto var_name = std::dynamic_pointer_cast<TableValue>(val); if(!var_name) throw std::runtime_error(msg(Msg::NATIVE_TABLE));
 
     globals->define("Exception", std::make_shared<NativeFnValue>("Exception", [](const std::vector<ValuePtr>& args){
         REQUIRE_ARGS("Exception", 1);
         return std::make_shared<ExceptionValue>(args[0]);
     }));
-    globals->define("abs", std::make_shared<NativeFnValue>("abs", [](const std::vector<ValuePtr>& args){
-        REQUIRE_ARGS("abs", 1); GET_NUM(args[0], num_val);
+    globals->define("abs", std::make_shared<NativeFnValue>("abs", [](const std::vector<ValuePtr>& args) -> ValuePtr {
+        REQUIRE_ARGS("abs", 1);
+        if (auto f_val = dynamic_cast<F64Value*>(args[0].get())) return std::make_shared<F64Value>(std::fabs(f_val->value));
+        GET_NUM(args[0], num_val);
         return std::make_shared<NumberValue>(num_val->value.abs());
     }));
     globals->define("len", std::make_shared<NativeFnValue>("len", [](const std::vector<ValuePtr>& args) {
         REQUIRE_ARGS("len", 1);
         if (auto str_val = dynamic_cast<StringValue*>(args[0].get()))
-            return std::make_shared<NumberValue>(BigNumber(std::to_string(str_val->value.length())));
+            return std::make_shared<NumberValue>(BigNumber((long long)str_val->length()));
         if (auto list_val = dynamic_cast<LnValue*>(args[0].get()))
             return std::make_shared<NumberValue>(BigNumber(std::to_string(list_val->elements.size())));
+        if (auto table_val = dynamic_cast<TableValue*>(args[0].get()))
+            return std::make_shared<NumberValue>(BigNumber((long long)table_val->rows));
         throw std::runtime_error("Argument to len() must be a string or a list.");
     }));
-    globals->define("rt", std::make_shared<NativeFnValue>("rt", [](const std::vector<ValuePtr>& args){
+    // format(fmt, ...) fills `{}` placeholders in order, or `{n}` by position, with the f-string specs.
+    globals->define("format", std::make_shared<NativeFnValue>("format", [](const std::vector<ValuePtr>& args){
+        REQUIRE_MIN_ARGS("format", 1);
+        auto fmt_val = dynamic_cast<StringValue*>(args[0].get());
+        if (!fmt_val) throw std::runtime_error(msg(Msg::NATIVE_STR));
+        size_t next = 1; // args[0] is the format string itself
+        FormatTemplate format = FormatTemplate::compile(fmt_val->value, [&next](const std::string& field) -> size_t {
+            if (field.empty()) return next++;
+            if (field.size() > 6 || field.find_first_not_of("0123456789") != std::string::npos)
+                throw std::runtime_error(msg(Msg::FORMAT_SPEC));
+            return std::stoul(field) + 1;
+        });
+        return std::make_shared<StringValue>(format.render(args));
+    }));
+    // String natives return new strings; positions count code points, like s[i], and -1 means not found.
+    globals->define("find", std::make_shared<NativeFnValue>("find", [](const std::vector<ValuePtr>& args){
+        if (args.size() != 2 && args.size() != 3) throw std::runtime_error(std::string("find") + fmt_int(Msg::NATIVE_ARGS, 3));
+        const StringValue& s = string_value(args[0]);
+        size_t from = 0;
+        if (args.size() == 3) {
+            long long start = count_arg(args[2]);
+            if (start > (long long)s.length()) return std::make_shared<NumberValue>(BigNumber(-1LL));
+            from = s.offset(start);
+        }
+        size_t pos = StringOps::find(s.value, string_arg(args[1]), from);
+        return std::make_shared<NumberValue>(BigNumber(pos == StringOps::npos ? -1LL : (long long)s.position(pos)));
+    }));
+    globals->define("rfind", std::make_shared<NativeFnValue>("rfind", [](const std::vector<ValuePtr>& args){
+        REQUIRE_ARGS("rfind", 2);
+        const StringValue& s = string_value(args[0]);
+        size_t pos = s.value.rfind(string_arg(args[1]));
+        return std::make_shared<NumberValue>(BigNumber(pos == std::string::npos ? -1LL : (long long)s.position(pos)));
+    }));
+    globals->define("count", std::make_shared<NativeFnValue>("count", [](const std::vector<ValuePtr>& args){
+        REQUIRE_ARGS("count", 2);
+        return std::make_shared<NumberValue>(BigNumber((long long)StringOps::count(string_arg(args[0]), pattern_arg(args[1]))));
+    }));
+    // split(s) splits on runs of whitespace; split(s, sep) keeps empty pieces.
+    globals->define("split", std::make_shared<NativeFnValue>("split", [](const std::vector<ValuePtr>& args){
+        if (args.size() != 1 && args.size() != 2) throw std::runtime_error(std::string("split") + fmt_int(Msg::NATIVE_ARGS, 2));
+        const std::string& s = string_arg(args[0]);
+        if (args.size() == 1) return string_list(StringOps::split_whitespace(s));
+        const std::string& sep = pattern_arg(args[1]);
+        if (s.empty()) return string_list({});
+        return string_list(StringOps::split(s, sep));
+    }));
+    globals->define("replace", std::make_shared<NativeFnValue>("replace", [](const std::vector<ValuePtr>& args){
+        REQUIRE_ARGS("replace", 3);
+        return std::make_shared<StringValue>(StringOps::replace(string_arg(args[0]), pattern_arg(args[1]), string_arg(args[2])));
+    }));
+    // join(ln, sep) converts non-string elements as say() would; the result is sized before copying.
+    globals->define("join", std::make_shared<NativeFnValue>("join", [](const std::vector<ValuePtr>& args){
+        if (args.size() != 1 && args.size() != 2) throw std::runtime_error(std::string("join") + fmt_int(Msg::NATIVE_ARGS, 2));
+        GET_LN(args[0], list);
+        static const std::string no_sep;
+        const std::string& sep = args.size() == 2 ? string_arg(args[1]) : no_sep;
+        const auto& elements = list->elements;
+        std::vector<std::string> converted(elements.size());
+        std::vector<const std::string*> parts(elements.size());
+        size_t total = elements.empty() ? 0 : sep.size() * (elements.size() - 1);
+        for (size_t i = 0; i < elements.size(); ++i) {
+            if (auto str_val = dynamic_cast<StringValue*>(elements[i].get())) parts[i] = &str_val->value;
+            else { converted[i] = elements[i]->toString(); parts[i] = &converted[i]; }
+            total += parts[i]->size();
+        }
+        std::string out;
+        out.reserve(total);
+        for (size_t i = 0; i < parts.size(); ++i) {
+            if (i) out += sep;
+            out += *parts[i];
+        }
+        return std::make_shared<StringValue>(out);
+    }));
+    globals->define("starts_with", std::make_shared<NativeFnValue>("starts_with", [](const std::vector<ValuePtr>& args){
+        REQUIRE_ARGS("starts_with", 2);
+        const std::string& s = string_arg(args[0]);
+        const std::string& prefix = string_arg(args[1]);
+        bool result = prefix.size() <= s.size() && s.compare(0, prefix.size(), prefix) == 0;
+        return std::make_shared<NumberValue>(result ? 1 : 0);
+    }));
+    globals->define("strip", std::make_shared<NativeFnValue>("strip", [](const std::vector<ValuePtr>& args){
+        REQUIRE_ARGS("strip", 1);
+        return std::make_shared<StringValue>(StringOps::strip(string_arg(args[0])));
+    }));
+    globals->define("upper", std::make_shared<NativeFnValue>("upper", [](const std::vector<ValuePtr>& args){
+        REQUIRE_ARGS("upper", 1);
+        return std::make_shared<StringValue>(StringOps::to_upper(string_arg(args[0])));
+    }));
+    globals->define("lower", std::make_shared<NativeFnValue>("lower", [](const std::vector<ValuePtr>& args){
+        REQUIRE_ARGS("lower", 1);
+        return std::make_shared<StringValue>(StringOps::to_lower(string_arg(args[0])));
+    }));
+    globals->define("rt", std::make_shared<NativeFnValue>("rt", [](const std::vector<ValuePtr>& args) -> ValuePtr {
         if (args.size() < 1 || args.size() > 2) throw std::runtime_error(msg(Msg::NATIVE_RT));
+        if (auto f_val = dynamic_cast<F64Value*>(args[0].get())) {
+            if (args.size() == 1) return std::make_shared<F64Value>(std::sqrt(f_val->value));
+            GET_NUM(args[1], n_val);
+            double n = n_val->value.toDouble(), x = f_val->value;
+            if (n == 3) return std::make_shared<F64Value>(std::cbrt(x));
+            // Odd roots of negative numbers are real; pow() would return nan.
+            if (x < 0 && std::fmod(n, 2) == 1) return std::make_shared<F64Value>(-std::pow(-x, 1 / n));
+            return std::make_shared<F64Value>(std::pow(x, 1 / n));
+        }
         GET_NUM(args[0], num_val);
         BigNumber n = 2;
         if (args.size() == 2) { GET_NUM(args[1], n_val); n = n_val->value; }
         return std::make_shared<NumberValue>(BigNumber::root(num_val->value, n));
     }));
+    globals->define("divmod", std::make_shared<NativeFnValue>("divmod", [](const std::vector<ValuePtr>& args){
+        REQUIRE_ARGS("divmod", 2); GET_NUM(args[0], a_val); GET_NUM(args[1], b_val);
+        if (!a_val->value.isInteger() || !b_val->value.isInteger())
+            throw std::runtime_error("Operands for modulo must be integers.");
+        BigNumber quot, rem;
+        BigNumber::divmod(a_val->value, b_val->value, quot, rem);
+        return std::make_shared<LnValue>(std::vector<ValuePtr>{std::make_shared<NumberValue>(quot), std::make_shared<NumberValue>(rem)});
+    }));
+    globals->define("sum", std::make_shared<NativeFnValue>("sum", [](const std::vector<ValuePtr>& args){
+        if (args.size() == 2) { GET_TABLE(args[0], table); return column_sum(table.get(), args[1]); }
+        REQUIRE_ARGS("sum", 1); GET_LN(args[0], list_val);
+        return sum_of(list_val);
+    }));
+    globals->define("prod", std::make_shared<NativeFnValue>("prod", [](const std::vector<ValuePtr>& args) -> ValuePtr {
+        REQUIRE_ARGS("prod", 1); GET_LN(args[0], list_val);
+        std::vector<const BigNumber*> decs;
+        if (collect_decs(list_val, decs)) return std::make_shared<NumberValue>(BigNumber::product(decs));
+        return fold_numbers(list_val, std::make_shared<NumberValue>(BigNumber(1)), true);
+    }));
+    globals->define("mean", std::make_shared<NativeFnValue>("mean", [](const std::vector<ValuePtr>& args){
+        if (args.size() == 2) {
+            GET_TABLE(args[0], table);
+            if (table->rows == 0) throw std::runtime_error(msg(Msg::NATIVE_MEAN_EMPTY));
+            return column_sum(table.get(), args[1])->divide(NumberValue(BigNumber((long long)table->rows)));
+        }
+        REQUIRE_ARGS("mean", 1); GET_LN(args[0], list_val);
+        if (list_val->elements.empty()) throw std::runtime_error(msg(Msg::NATIVE_MEAN_EMPTY));
+        return sum_of(list_val)->divide(NumberValue(BigNumber((long long)list_val->elements.size())));
+    }));
+    globals->define("dot", std::make_shared<NativeFnValue>("dot", [](const std::vector<ValuePtr>& args) -> ValuePtr {
+        REQUIRE_ARGS("dot", 2); GET_LN(args[0], a_val); GET_LN(args[1], b_val);
+        if (a_val->elements.size() != b_val->elements.size()) throw std::runtime_error(msg(Msg::NATIVE_DOT_LEN));
+        std::vector<const BigNumber*> a_decs, b_decs;
+        if (collect_decs(a_val, a_decs) && collect_decs(b_val, b_decs))
+            return std::make_shared<NumberValue>(BigNumber::dot(a_decs, b_decs));
+        ValuePtr acc = std::make_shared<NumberValue>(BigNumber(0));
+        for (size_t i = 0; i < a_val->elements.size(); ++i) {
+            Value* x = a_val->elements[i].get();
+            Value* y = b_val->elements[i].get();
+            if (!is_numeric(x) || !is_numeric(y)) throw std::runtime_error(msg(Msg::NATIVE_NUM));
+            acc = acc->add(*x->multiply(*y));
+        }
+        return acc;
+    }));
+    globals->define("factorial", std::make_shared<NativeFnValue>("factorial", [](const std::vector<ValuePtr>& args){
+        REQUIRE_ARGS("factorial", 1);
+        return std::make_shared<NumberValue>(BigNumber::factorial(count_arg(args[0], MAX_FACTORS)));
+    }));
+    globals->define("binomial", std::make_shared<NativeFnValue>("binomial", [](const std::vector<ValuePtr>& args){
+        REQUIRE_ARGS("binomial", 2);
+        long long n = count_arg(args[0], LLONG_MAX - 1), k = count_arg(args[1]);
+        if (k <= n && std::min(k, n - k) > MAX_FACTORS) throw std::runtime_error(msg(Msg::NATIVE_TOO_LARGE));
+        return std::make_shared<NumberValue>(BigNumber::binomial(n, k));
+    }));
+    globals->define("perm", std::make_shared<NativeFnValue>("perm", [](const std::vector<ValuePtr>& args){
+        REQUIRE_ARGS("perm", 2);
+        long long n = count_arg(args[0], LLONG_MAX - 1), k = count_arg(args[1]);
+        if (k <= n && k > MAX_FACTORS) throw std::runtime_error(msg(Msg::NATIVE_TOO_LARGE));
+        return std::make_shared<NumberValue>(BigNumber::perm(n, k));
+    }));
+    globals->define("fib", std::make_shared<NativeFnValue>("fib", [](const std::vector<ValuePtr>& args){
+        REQUIRE_ARGS("fib", 1);
+        return std::make_shared<NumberValue>(BigNumber::fibonacci(count_arg(args[0], MAX_FIB)));
+    }));
+    globals->define("seed", std::make_shared<NativeFnValue>("seed", [](const std::vector<ValuePtr>& args){
+        REQUIRE_ARGS("seed", 1); GET_NUM(args[0], seed_val);
+        Random::global().seed((uint64_t)seed_val->value.toLongLong());
+        return std::make_shared<NullValue>();
+    }));
+    globals->define("random", std::make_shared<NativeFnValue>("random", [](const std::vector<ValuePtr>& args){
+        REQUIRE_ARGS("random", 0);
+        return std::make_shared<F64Value>(Random::global().uniform());
+    }));
+    globals->define("randint", std::make_shared<NativeFnValue>("randint", [](const std::vector<ValuePtr>& args){
+        REQUIRE_ARGS("randint", 2);
+        BigNumber lo, hi;
+        random_bounds(args[0], args[1], lo, hi);
+        return std::make_shared<NumberValue>(Random::global().between(lo, hi));
+    }));
+    globals->define("shuffle", std::make_shared<NativeFnValue>("shuffle", [](const std::vector<ValuePtr>& args){
+        REQUIRE_ARGS("shuffle", 1); GET_LN(args[0], list_val);
+        auto new_list = std::make_shared<LnValue>(list_val->elements);
+        std::vector<ValuePtr>& elems = new_list->elements;
+        for (size_t i = elems.size(); i > 1; --i) std::swap(elems[i - 1], elems[Random::global().below(i)]);
+        return new_list;
+    }));
+    // random_ln(n) fills an ln with f64 values in [0, 1); random_ln(n, a, b) with integers in [a, b].
+    globals->define("random_ln", std::make_shared<NativeFnValue>("random_ln", [](const std::vector<ValuePtr>& args){
+        if (args.size() != 1 && args.size() != 3) throw std::runtime_error(std::string("random_ln") + fmt_int(Msg::NATIVE_ARGS, 3));
+        long long n = count_arg(args[0]);
+        Random& rng = Random::global();
+        std::vector<ValuePtr> elements;
+        elements.reserve(n);
+        if (args.size() == 1) {
+            for (long long i = 0; i < n; ++i) elements.push_back(std::make_shared<F64Value>(rng.uniform()));
+            return std::make_shared<LnValue>(elements);
+        }
+        BigNumber lo, hi;
+        random_bounds(args[1], args[2], lo, hi);
+        long long lo_small, span;
+        if (lo.toSmallInt(lo_small) && (hi - lo + BigNumber(1)).toSmallInt(span)) {
+            for (long long i = 0; i < n; ++i) elements.push_back(std::make_shared<NumberValue>(BigNumber(lo_small + (long long)rng.below(span))));
+        } else {
+            for (long long i = 0; i < n; ++i) elements.push_back(std::make_shared<NumberValue>(rng.between(lo, hi)));
+        }
+        return std::make_shared<LnValue>(elements);
+    }));
+    globals->define("random_bin", std::make_shared<NativeFnValue>("random_bin", [](const std::vector<ValuePtr>& args){
+        REQUIRE_ARGS("random_bin", 1);
+        std::vector<uint8_t> bytes(count_arg(args[0]));
+        Random::global().fill_bytes(bytes);
+        return std::make_shared<BinaryValue>(bytes);
+    }));
+    globals->define("random_digits", std::make_shared<NativeFnValue>("random_digits", [](const std::vector<ValuePtr>& args){
+        REQUIRE_ARGS("random_digits", 1);
+        long long n = count_arg(args[0]);
+        if (n > INT_MAX) throw std::runtime_error(msg(Msg::NATIVE_COUNT));
+        return std::make_shared<NumberValue>(BigNumber(Random::global().decimal_digits((int)n, true), false, 0));
+    }));
+    // memo(fn, capacity) caches fn's results by argument value; the same
+    // function object is returned, so recursive calls through its name hit too.
+    globals->define("memo", std::make_shared<NativeFnValue>("memo", [](const std::vector<ValuePtr>& args){
+        if (args.size() != 1 && args.size() != 2) throw std::runtime_error(std::string("memo") + fmt_int(Msg::NATIVE_ARGS, 2));
+        auto fn_val = dynamic_cast<FunctionValue*>(args[0].get());
+        if (!fn_val) throw std::runtime_error(msg(Msg::NATIVE_MEMO_FN));
+        size_t capacity = args.size() == 2 ? (size_t)count_arg(args[1]) : MemoCache::DEFAULT_CAPACITY;
+        fn_val->value->memo = std::make_shared<MemoCache>(capacity);
+        return args[0];
+    }));
+    globals->define("memo_stats", std::make_shared<NativeFnValue>("memo_stats", [](const std::vector<ValuePtr>& args){
+        REQUIRE_ARGS("memo_stats", 1);
+        auto fn_val = dynamic_cast<FunctionValue*>(args[0].get());
+        if (!fn_val) throw std::runtime_error(msg(Msg::NATIVE_MEMO_FN));
+        std::map<std::string, ValuePtr> stats;
+        const MemoCache* cache = fn_val->value->memo.get();
+        stats["hits"] = std::make_shared<NumberValue>(BigNumber(cache ? cache->hits : 0));
+        stats["misses"] = std::make_shared<NumberValue>(BigNumber(cache ? cache->misses : 0));
+        stats["size"] = std::make_shared<NumberValue>(BigNumber(cache ? (long long)cache->size() : 0));
+        stats["capacity"] = std::make_shared<NumberValue>(BigNumber(cache ? (long long)cache->capacity : 0));
+        return std::make_shared<DimValue>(stats);
+    }));
+    // Struct-of-arrays tables: table(Point) holds Point rows column by column.
+    globals->define("table", std::make_shared<NativeFnValue>("table", [](const std::vector<ValuePtr>& args){
+        if (args.size() != 1 && args.size() != 2) throw std::runtime_error(std::string("table") + fmt_int(Msg::NATIVE_ARGS, 2));
+        auto class_val = std::dynamic_pointer_cast<Class>(args[0]);
+        if (!class_val || !class_val->methods.empty() || !class_val->initializer_body.empty())
+            throw std::runtime_error(msg(Msg::TABLE_STRUCT));
+        auto table = std::make_shared<TableValue>(class_val);
+        if (args.size() == 2) {
+            table->append_defaults(count_arg(args[1]));
+        }
+        return table;
+    }));
+    // append(t, instance) copies an instance's fields; append(t, v1, v2, ...) gives them in order.
+    globals->define("append", std::make_shared<NativeFnValue>("append", [](const std::vector<ValuePtr>& args){
+        REQUIRE_MIN_ARGS("append", 1); GET_TABLE(args[0], table);
+        auto instance = args.size() == 2 ? dynamic_cast<Instance*>(args[1].get()) : nullptr;
+        if (instance && instance->klass == table->klass) table->append(*instance);
+        else table->append(std::vector<ValuePtr>(args.begin() + 1, args.end()));
+        return std::make_shared<NullValue>();
+    }));
+    globals->define("column", std::make_shared<NativeFnValue>("column", [](const std::vector<ValuePtr>& args){
+        REQUIRE_ARGS("column", 2); GET_TABLE(args[0], table);
+        const TableValue::Column& column = table_column(table.get(), args[1]);
+        std::vector<ValuePtr> elements;
+        elements.reserve(table->rows);
+        for (size_t row = 0; row < table->rows; ++row) elements.push_back(column.get(row));
+        return std::make_shared<LnValue>(elements);
+    }));
+    // sort_by(t, field, descending = 0) returns a new table; the sort compares column entries directly.
+    globals->define("sort_by", std::make_shared<NativeFnValue>("sort_by", [](const std::vector<ValuePtr>& args){
+        if (args.size() != 2 && args.size() != 3) throw std::runtime_error(std::string("sort_by") + fmt_int(Msg::NATIVE_ARGS, 3));
+        GET_TABLE(args[0], table);
+        const TableValue::Column& column = table_column(table.get(), args[1]);
+        bool descending = args.size() == 3 && args[2]->isTruthy();
+        std::vector<size_t> order(table->rows);
+        for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+        std::function<bool(size_t, size_t)> less;
+        if (column.unboxed()) {
+            // Null entries sort first.
+            if (column.type == TokenType::DEC)
+                less = [&column](size_t a, size_t b) { return column.present[a] != column.present[b] ? column.present[b] : column.present[a] && column.decs[a] < column.decs[b]; };
+            else
+                less = [&column](size_t a, size_t b) { return column.present[a] != column.present[b] ? column.present[b] : column.present[a] && column.f64s[a] < column.f64s[b]; };
+        } else {
+            less = [&column](size_t a, size_t b) { try { return column.values[a]->isLessThan(*column.values[b]); } catch (...) { return false; } };
+        }
+        if (descending) std::stable_sort(order.begin(), order.end(), [&less](size_t a, size_t b) { return less(b, a); });
+        else std::stable_sort(order.begin(), order.end(), less);
+        return table->select(order);
+    }));
+    // filter(t, fn) keeps the rows for which fn(row) is truthy; filter(ln, fn) does the same for elements.
+    globals->define("filter", std::make_shared<NativeFnValue>("filter", [this](const std::vector<ValuePtr>& args) -> ValuePtr {
+        REQUIRE_ARGS("filter", 2);
+        const ValuePtr& predicate = args[1];
+        auto test = [this, &predicate](const ValuePtr& item) {
+            std::vector<ValuePtr> call_args{item};
+            if (auto fn_val = dynamic_cast<FunctionValue*>(predicate.get())) return this->call_function(fn_val->value, call_args, 0)->isTruthy();
+            if (auto native_fn = dynamic_cast<NativeFnValue*>(predicate.get())) return native_fn->call(call_args)->isTruthy();
+            throw std::runtime_error(fmt(Msg::CALL_ONLY, predicate->repr()));
+        };
+        if (auto list_val = dynamic_cast<LnValue*>(args[0].get())) {
+            std::vector<ValuePtr> kept;
+            for (const auto& elem : list_val->elements) if (test(elem)) kept.push_back(elem);
+            return std::make_shared<LnValue>(kept);
+        }
+        GET_TABLE(args[0], table);
+        std::vector<size_t> kept;
+        for (size_t row = 0; row < table->rows; ++row)
+            if (test(std::make_shared<RowValue>(table, row))) kept.push_back(row);
+        return table->select(kept);
+    }));
     globals->define("sort", std::make_shared<NativeFnValue>("sort", [](const std::vector<ValuePtr>& args){
         REQUIRE_ARGS("sort", 1); GET_LN(args[0], list_val);
         auto new_list = std::make_shared<LnValue>(list_val->elements);
@@ -824,20 +1721,69 @@ void Interpreter::define_native_functions() {
         hash_val ^= key;
         return std::make_shared<NumberValue>(BigNumber((long long)hash_val));
     }));
-    globals->define("sin", std::make_shared<NativeFnValue>("sin", [](const std::vector<ValuePtr>& args) {
-        REQUIRE_ARGS("sin", 1); GET_NUM(args[0], x);
+    globals->define("xxhash64", std::make_shared<NativeFnValue>("xxhash64", [](const std::vector<ValuePtr>& args){
+        if (args.size() != 1 && args.size() != 2) throw std::runtime_error(std::string("xxhash64") + fmt_int(Msg::NATIVE_ARGS, 2));
+        uint64_t seed = 0;
+        if (args.size() == 2) { GET_NUM(args[1], seed_val); seed = (uint64_t)seed_val->value.toLongLong(); }
+        const uint8_t* data; size_t len; std::string holder;
+        hash_input(args[0], data, len, holder);
+        return unsigned_value(Hash::xxhash64(data, len, seed));
+    }));
+    globals->define("crc32", std::make_shared<NativeFnValue>("crc32", [](const std::vector<ValuePtr>& args){
+        REQUIRE_ARGS("crc32", 1);
+        const uint8_t* data; size_t len; std::string holder;
+        hash_input(args[0], data, len, holder);
+        return unsigned_value(Hash::crc32(data, len));
+    }));
+    globals->define("sha256", std::make_shared<NativeFnValue>("sha256", [](const std::vector<ValuePtr>& args){
+        REQUIRE_ARGS("sha256", 1);
+        const uint8_t* data; size_t len; std::string holder;
+        hash_input(args[0], data, len, holder);
+        return std::make_shared<BinaryValue>(Hash::sha256(data, len));
+    }));
+    globals->define("siphash", std::make_shared<NativeFnValue>("siphash", [](const std::vector<ValuePtr>& args){
+        REQUIRE_ARGS("siphash", 2);
+        uint64_t k0 = 0, k1 = 0;
+        if (auto key_bin = dynamic_cast<BinaryValue*>(args[1].get())) {
+            if (key_bin->value.size() != 16) throw std::runtime_error(msg(Msg::NATIVE_SIP_KEY));
+            k0 = Hash::read64(key_bin->value.data());
+            k1 = Hash::read64(key_bin->value.data() + 8);
+        } else if (auto key_num = number_arg(args[1])) {
+            if (!key_num->value.isInteger()) throw std::runtime_error(msg(Msg::NATIVE_SIP_KEY));
+            k0 = (uint64_t)key_num->value.toLongLong();
+        } else {
+            throw std::runtime_error(msg(Msg::NATIVE_SIP_KEY));
+        }
+        const uint8_t* data; size_t len; std::string holder;
+        hash_input(args[0], data, len, holder);
+        return unsigned_value(Hash::siphash(data, len, k0, k1));
+    }));
+    globals->define("structural_hash", std::make_shared<NativeFnValue>("structural_hash", [](const std::vector<ValuePtr>& args){
+        REQUIRE_ARGS("structural_hash", 1);
+        return unsigned_value(structural_hash(args[0].get()));
+    }));
+    globals->define("sin", std::make_shared<NativeFnValue>("sin", [](const std::vector<ValuePtr>& args) -> ValuePtr {
+        REQUIRE_ARGS("sin", 1);
+        if (auto f_val = dynamic_cast<F64Value*>(args[0].get())) return std::make_shared<F64Value>(std::sin(f_val->value));
+        GET_NUM(args[0], x);
         return std::make_shared<NumberValue>(BigNumber(std::to_string(sin(x->value.toLongLong()))));
     }));
-    globals->define("cos", std::make_shared<NativeFnValue>("cos", [](const std::vector<ValuePtr>& args) {
-        REQUIRE_ARGS("cos", 1); GET_NUM(args[0], x);
+    globals->define("cos", std::make_shared<NativeFnValue>("cos", [](const std::vector<ValuePtr>& args) -> ValuePtr {
+        REQUIRE_ARGS("cos", 1);
+        if (auto f_val = dynamic_cast<F64Value*>(args[0].get())) return std::make_shared<F64Value>(std::cos(f_val->value));
+        GET_NUM(args[0], x);
         return std::make_shared<NumberValue>(BigNumber(std::to_string(cos(x->value.toLongLong()))));
     }));
-    globals->define("tan", std::make_shared<NativeFnValue>("tan", [](const std::vector<ValuePtr>& args) {
-        REQUIRE_ARGS("tan", 1); GET_NUM(args[0], x);
+    globals->define("tan", std::make_shared<NativeFnValue>("tan", [](const std::vector<ValuePtr>& args) -> ValuePtr {
+        REQUIRE_ARGS("tan", 1);
+        if (auto f_val = dynamic_cast<F64Value*>(args[0].get())) return std::make_shared<F64Value>(std::tan(f_val->value));
+        GET_NUM(args[0], x);
         return std::make_shared<NumberValue>(BigNumber(std::to_string(tan(x->value.toLongLong()))));
     }));
-    globals->define("log", std::make_shared<NativeFnValue>("log", [](const std::vector<ValuePtr>& args) {
-        REQUIRE_ARGS("log", 1); GET_NUM(args[0], x);
+    globals->define("log", std::make_shared<NativeFnValue>("log", [](const std::vector<ValuePtr>& args) -> ValuePtr {
+        REQUIRE_ARGS("log", 1);
+        if (auto f_val = dynamic_cast<F64Value*>(args[0].get())) return std::make_shared<F64Value>(std::log(f_val->value));
+        GET_NUM(args[0], x);
         if (x->value <= BigNumber(0)) throw std::runtime_error(msg(Msg::NATIVE_LOG_POS));
         return std::make_shared<NumberValue>(BigNumber(std::to_string(log(x->value.toLongLong()))));
     }));
@@ -862,8 +1808,20 @@ void Interpreter::define_native_functions() {
     globals->define("get_precision", std::make_shared<NativeFnValue>("get_precision", [](const std::vector<ValuePtr>& args){
         return std::make_shared<NumberValue>(BigNumber(BigNumber::get_default_precision()));
     }));
+    globals->define("exact_mode", std::make_shared<NativeFnValue>("exact_mode", [](const std::vector<ValuePtr>& args){
+        if (args.size() > 1) throw std::runtime_error("exact_mode() takes 0 or 1 arguments.");
+        bool previous = Rational::exact_mode();
+        if (args.size() == 1) Rational::exact_mode_ref() = args[0]->isTruthy();
+        return std::make_shared<NumberValue>(previous ? 1 : 0);
+    }));
     globals->define("approx", std::make_shared<NativeFnValue>("approx", [](const std::vector<ValuePtr>& args){
-        REQUIRE_ARGS("approx", 2); GET_NUM(args[0], num_to_approx); GET_NUM(args[1], precision_val);
+        REQUIRE_ARGS("approx", 2); GET_NUM(args[1], precision_val);
+        if (auto r_val = dynamic_cast<RationalValue*>(args[0].get())) {
+            long long p = precision_val->value.toLongLong();
+            if (p < 0) throw std::runtime_error("Precision cannot be negative.");
+            return std::make_shared<NumberValue>(r_val->value.toBigNumber(p));
+        }
+        GET_NUM(args[0], num_to_approx);
         try { return std::make_shared<NumberValue>(num_to_approx->value.approx(precision_val->value.toLongLong())); }
         catch (const std::exception& e) { throw std::runtime_error(e.what()); }
     }));
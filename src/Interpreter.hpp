@@ -8,11 +8,21 @@
 #include "Environment.hpp"
 #include "Ast.hpp"
 #include "Parser.hpp"
+#include "msgs.hpp"
 
+// Errors raised with a Msg id keep the id and its arguments; the text is only
+// built when what() is first called, e.g. when printed or bound by `catch`.
 class RuntimeError : public std::runtime_error {
 public:
     int line;
-    RuntimeError(int l, const std::string& msg) : std::runtime_error(msg), line(l) {}
+    Msg id;
+    std::vector<std::string> args;
+    RuntimeError(int l, const std::string& msg) : std::runtime_error(msg), line(l), id(Msg::RUNTIME_PREFIX), lazy(false) {}
+    RuntimeError(int l, Msg m, std::vector<std::string> a) : std::runtime_error(""), line(l), id(m), args(std::move(a)), lazy(true) {}
+    const char* what() const noexcept override;
+private:
+    bool lazy;
+    mutable std::string text;
 };
 
 class ReturnValueException : public std::runtime_error {
@@ -37,8 +47,12 @@ public:
 };
 
 class Interpreter {
+    // Arena of every parse whose nodes this interpreter may run. Declared
+    // first so it is destroyed after everything else that can hold a node.
+    std::vector<std::shared_ptr<AstArena>> arenas;
 public:
     Interpreter();
+    void keep_arena(const std::shared_ptr<AstArena>& arena) { arenas.push_back(arena); }
     std::string base_path;
     void interpret(const std::vector<AstNodePtr>& statements);
     void execute(const AstNodePtr& stmt);
@@ -46,6 +60,7 @@ public:
     void execute_block(const std::vector<AstNodePtr>& statements, std::shared_ptr<Environment> block_env);
     void check_timeout(int line);
     void assignToLValue(AstNodePtr target, ValuePtr val, int line);
+    ValuePtr call_function(const std::shared_ptr<Function>& function, const std::vector<ValuePtr>& arg_values, int line, const InstancePtr& instance = nullptr);
     ValuePtr load_module(class ModuleProxy* proxy);
     std::string resolve_module_path(const std::string& path);
 
@@ -53,12 +68,14 @@ public:
     long long time_limit_ms;
     struct CallInfo { std::string function_name; int call_site_line; };
     std::vector<CallInfo> call_stack;
+    const ValuePtr* inline_args = nullptr; // Arguments of the InlinedCallNode being evaluated
     std::shared_ptr<Environment> globals;
     std::shared_ptr<Environment> environment;
     std::string repl_buffer;
 
 private:
     void define_native_functions();
+    const std::vector<AstNodePtr>& body_of(Function& function);
     void print_stack_trace();
     std::set<std::string> loading_modules;
 };
@@ -0,0 +1,65 @@
+#pragma once
+#include <cstdint>
+#include <iterator>
+#include <list>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+#include "Value.hpp"
+
+// Result cache that memo() attaches to a Function. Keys are the argument
+// values, looked up by their structural hash and confirmed with ==; the least
+// recently used entry is evicted once `capacity` entries are held.
+class MemoCache {
+public:
+    static const size_t DEFAULT_CAPACITY = 65536;
+    size_t capacity;
+    long long hits = 0, misses = 0;
+
+    explicit MemoCache(size_t cap) : capacity(cap) {}
+
+    size_t size() const { return entries.size(); }
+
+    bool lookup(uint64_t key, const std::vector<ValuePtr>& args, ValuePtr& result) {
+        auto range = index.equal_range(key);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (!same_args(it->second->args, args)) continue;
+            entries.splice(entries.begin(), entries, it->second);
+            result = it->second->result;
+            ++hits;
+            return true;
+        }
+        ++misses;
+        return false;
+    }
+
+    void store(uint64_t key, const std::vector<ValuePtr>& args, const ValuePtr& result) {
+        if (capacity == 0) return;
+        if (entries.size() >= capacity) {
+            auto range = index.equal_range(entries.back().key);
+            for (auto it = range.first; it != range.second; ++it) {
+                if (it->second == std::prev(entries.end())) { index.erase(it); break; }
+            }
+            entries.pop_back();
+        }
+        entries.push_front(Entry{key, args, result});
+        index.emplace(key, entries.begin());
+    }
+
+private:
+    struct Entry {
+        uint64_t key;
+        std::vector<ValuePtr> args;
+        ValuePtr result;
+    };
+    std::list<Entry> entries; // Most recently used first
+    std::unordered_multimap<uint64_t, std::list<Entry>::iterator> index;
+
+    static bool same_args(const std::vector<ValuePtr>& a, const std::vector<ValuePtr>& b) {
+        if (a.size() != b.size()) return false;
+        for (size_t i = 0; i < a.size(); ++i) {
+            if (typeid(*a[i]) != typeid(*b[i]) || !a[i]->isEqualTo(*b[i])) return false;
+        }
+        return true;
+    }
+};
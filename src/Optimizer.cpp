@@ -0,0 +1,225 @@
+#include "Optimizer.hpp"
+#include <typeinfo>
+
+void Optimizer::run(std::vector<AstNodePtr>& statements) {
+    for (const auto& stmt : statements) {
+        if (auto fn_node = dynamic_cast<FnDefNode*>(stmt.get())) {
+            if (!fn_node->is_memo && !fn_node->is_method && !fn_node->lazy_body)
+                consider(fn_node->name, fn_node->params, fn_node->body);
+        } else if (auto var_node = dynamic_cast<VarDeclarationNode*>(stmt.get())) {
+            // Only `dec` and `any` leave a function value unconverted.
+            auto lambda = dynamic_cast<LambdaNode*>(var_node->initializer.get());
+            if (lambda && (var_node->keyword == TokenType::DEC || var_node->keyword == TokenType::ANY))
+                consider(var_node->name, lambda->params, lambda->body);
+        }
+    }
+    if (!candidates.empty()) {
+        for (const auto& stmt : statements) count_bindings(stmt.get());
+        for (auto it = candidates.begin(); it != candidates.end();) {
+            if (bindings[it->first] != 1) it = candidates.erase(it);
+            else ++it;
+        }
+    }
+    for (auto& stmt : statements) rewrite(stmt);
+}
+
+void Optimizer::consider(const std::string& name, const std::vector<ParameterDefinition>& params, const std::vector<AstNodePtr>& body) {
+    if (params.size() > InlinedCallNode::MAX_ARGS || body.size() != 1) return;
+    auto ret = dynamic_cast<ReturnNode*>(body[0].get());
+    if (!ret || !ret->value) return;
+    for (size_t i = 0; i < params.size(); ++i) {
+        if (params[i].default_expr || (i > 0 && params[i - 1].has_default && !params[i].has_default)) return;
+        for (size_t j = 0; j < i; ++j) if (params[j].name == params[i].name) return;
+    }
+    size_t budget = MAX_INLINE_NODES;
+    AstNodePtr expr = substitute(ret->value, params, budget);
+    if (expr) candidates[name] = Candidate{&params, body[0], expr};
+}
+
+// Copies `expr` with each parameter read replaced by an InlineArgNode. Returns
+// nullptr for anything but operators over literals and parameters, and for
+// expressions larger than the node budget.
+AstNodePtr Optimizer::substitute(const AstNodePtr& expr, const std::vector<ParameterDefinition>& params, size_t& budget) {
+    if (!expr || budget == 0) return nullptr;
+    --budget;
+    AstNode* node = expr.get();
+    if (dynamic_cast<LiteralNode*>(node)) return expr;
+    if (auto var = dynamic_cast<VariableNode*>(node)) {
+        for (size_t i = 0; i < params.size(); ++i)
+            if (params[i].name == var->name) return std::make_shared<InlineArgNode>(var->line, i);
+        return nullptr; // A free variable would tie the body to its scope
+    }
+    if (auto bin = dynamic_cast<BinaryOpNode*>(node)) {
+        AstNodePtr left = substitute(bin->left, params, budget);
+        AstNodePtr right = left ? substitute(bin->right, params, budget) : nullptr;
+        return right ? std::make_shared<BinaryOpNode>(bin->line, left, bin->op, right) : nullptr;
+    }
+    if (auto logical = dynamic_cast<LogicalOpNode*>(node)) {
+        AstNodePtr left = substitute(logical->left, params, budget);
+        AstNodePtr right = left ? substitute(logical->right, params, budget) : nullptr;
+        return right ? std::make_shared<LogicalOpNode>(logical->line, left, logical->op, right) : nullptr;
+    }
+    if (auto unary = dynamic_cast<UnaryOpNode*>(node)) {
+        AstNodePtr right = substitute(unary->right, params, budget);
+        return right ? std::make_shared<UnaryOpNode>(unary->line, unary->op, right) : nullptr;
+    }
+    if (auto conv = dynamic_cast<TypeConversionNode*>(node)) {
+        AstNodePtr inner = substitute(conv->expression, params, budget);
+        return inner ? std::make_shared<TypeConversionNode>(conv->line, inner, conv->type_keyword) : nullptr;
+    }
+    return nullptr;
+}
+
+// Counts every construct that can bind a name: declarations, assignments,
+// parameters, loop and catch variables, aliases and struct/class fields.
+void Optimizer::count_bindings(AstNode* node) {
+    if (!node) return;
+    auto bind_target = [this](AstNode* target) {
+        if (auto var = dynamic_cast<VariableNode*>(target)) ++bindings[var->name];
+    };
+    auto bind_params = [this](const std::vector<ParameterDefinition>& params) {
+        for (const auto& p : params) ++bindings[p.name];
+    };
+    if (auto n = dynamic_cast<FnDefNode*>(node)) { ++bindings[n->name]; bind_params(n->params); }
+    else if (auto n = dynamic_cast<LambdaNode*>(node)) bind_params(n->params);
+    else if (auto n = dynamic_cast<VarDeclarationNode*>(node)) ++bindings[n->name];
+    else if (auto n = dynamic_cast<AssignmentNode*>(node)) bind_target(n->target.get());
+    else if (auto n = dynamic_cast<CompoundAssignmentNode*>(node)) bind_target(n->target.get());
+    else if (auto n = dynamic_cast<SwapNode*>(node)) { bind_target(n->left.get()); bind_target(n->right.get()); }
+    else if (auto n = dynamic_cast<ForInNode*>(node)) ++bindings[n->var_name];
+    else if (auto n = dynamic_cast<LoopForNode*>(node)) ++bindings[n->index_var_name];
+    else if (auto n = dynamic_cast<LoopUntilNode*>(node)) ++bindings[n->index_var_name];
+    else if (auto n = dynamic_cast<TryCatchNode*>(node)) ++bindings[n->exception_var];
+    else if (auto n = dynamic_cast<UsingNode*>(node)) ++bindings[n->alias_name];
+    else if (auto n = dynamic_cast<RequireNode*>(node)) {
+        std::string alias = n->alias_name;
+        if (alias.empty()) {
+            size_t pos = n->module_path.find_last_of("/\\");
+            alias = pos == std::string::npos ? n->module_path : n->module_path.substr(pos + 1);
+        }
+        ++bindings[alias];
+    }
+    else if (auto n = dynamic_cast<ClassDefNode*>(node)) { ++bindings[n->name]; bind_params(n->fields); }
+    else if (auto n = dynamic_cast<StructDefNode*>(node)) { ++bindings[n->name]; bind_params(n->fields); }
+
+    std::vector<AstNodePtr*> slots;
+    child_slots(node, slots);
+    for (AstNodePtr* slot : slots) count_bindings(slot->get());
+}
+
+void Optimizer::rewrite(AstNodePtr& slot) {
+    if (!slot) return;
+    std::vector<AstNodePtr*> slots;
+    child_slots(slot.get(), slots);
+    for (AstNodePtr* child : slots) rewrite(*child);
+
+    if (auto loop = dynamic_cast<WhileStatementNode*>(slot.get())) { mark_counted(loop); return; }
+    auto call = std::dynamic_pointer_cast<CallNode>(slot);
+    if (!call) return;
+    auto callee = dynamic_cast<VariableNode*>(call->callee.get());
+    if (!callee) return;
+    auto it = candidates.find(callee->name);
+    if (it == candidates.end()) return;
+    const auto& params = *it->second.params;
+    size_t required = 0;
+    for (const auto& p : params) if (!p.has_default) ++required;
+    if (call->arguments.size() < required || call->arguments.size() > params.size()) return;
+    slot = std::make_shared<InlinedCallNode>(call->line, call, it->second.origin, it->second.expr);
+}
+
+// Recognizes `while i <cmp> bound do ... i += step end`, where step is an
+// integer literal and no statement of the body itself declares i.
+void Optimizer::mark_counted(WhileStatementNode* loop) {
+    auto cmp = dynamic_cast<BinaryOpNode*>(loop->condition.get());
+    if (!cmp || loop->do_branch.empty()) return;
+    switch (cmp->op) {
+        case TokenType::LESS: case TokenType::LESS_EQUAL: case TokenType::GREATER:
+        case TokenType::GREATER_EQUAL: case TokenType::BANG_EQUAL: break;
+        default: return;
+    }
+    auto counter = dynamic_cast<VariableNode*>(cmp->left.get());
+    if (!counter) return;
+    long long step = step_of(loop->do_branch.back().get(), counter->name);
+    if (!step) return;
+    for (const auto& stmt : loop->do_branch) {
+        AstNode* s = stmt.get();
+        std::string declared;
+        if (auto n = dynamic_cast<VarDeclarationNode*>(s)) declared = n->name;
+        else if (auto n = dynamic_cast<FnDefNode*>(s)) declared = n->name;
+        else if (auto n = dynamic_cast<ClassDefNode*>(s)) declared = n->name;
+        else if (auto n = dynamic_cast<StructDefNode*>(s)) declared = n->name;
+        else if (auto n = dynamic_cast<UsingNode*>(s)) declared = n->alias_name;
+        else if (dynamic_cast<RequireNode*>(s)) return; // Its alias is derived at run time
+        if (declared == counter->name) return;
+    }
+    loop->counter = counter->name;
+    loop->step = step;
+    loop->counted_body.assign(loop->do_branch.begin(), loop->do_branch.end() - 1);
+}
+
+// The literal step of `name += k`, `name -= k`, `name = name + k` or
+// `name = name - k`, or 0 when `stmt` is none of these.
+long long Optimizer::step_of(AstNode* stmt, const std::string& name) {
+    static const long long MAX_STEP = 1000000000LL;
+    auto expr = dynamic_cast<ExpressionStatementNode*>(stmt);
+    if (!expr) return 0;
+    BinaryOpNode* operation = nullptr;
+    AstNode* target = nullptr;
+    if (auto n = dynamic_cast<CompoundAssignmentNode*>(expr->expression.get())) {
+        target = n->target.get();
+        operation = n->operation.get();
+    } else if (auto n = dynamic_cast<AssignmentNode*>(expr->expression.get())) {
+        target = n->target.get();
+        operation = dynamic_cast<BinaryOpNode*>(n->value.get());
+        auto self = operation ? dynamic_cast<VariableNode*>(operation->left.get()) : nullptr;
+        if (!self || self->name != name) return 0;
+    }
+    auto var = dynamic_cast<VariableNode*>(target);
+    if (!var || var->name != name) return 0;
+    if (operation->op != TokenType::PLUS && operation->op != TokenType::MINUS) return 0;
+    auto lit = dynamic_cast<LiteralNode*>(operation->right.get());
+    long long k;
+    if (!lit || typeid(*lit->value) != typeid(NumberValue)
+        || !static_cast<NumberValue*>(lit->value.get())->value.toSmallInt(k)
+        || k == 0 || k > MAX_STEP || k < -MAX_STEP) return 0;
+    return operation->op == TokenType::PLUS ? k : -k;
+}
+
+// Every child node slot of `node`, in evaluation order where it matters.
+void Optimizer::child_slots(AstNode* node, std::vector<AstNodePtr*>& out) {
+    auto add = [&out](AstNodePtr& slot) { if (slot) out.push_back(&slot); };
+    auto add_all = [&out](std::vector<AstNodePtr>& block) { for (auto& stmt : block) if (stmt) out.push_back(&stmt); };
+    auto add_defaults = [&out](std::vector<ParameterDefinition>& params) { for (auto& p : params) if (p.default_expr) out.push_back(&p.default_expr); };
+
+    if (auto n = dynamic_cast<ListLiteralNode*>(node)) add_all(n->elements);
+    else if (auto n = dynamic_cast<FormatStringNode*>(node)) add_all(n->args);
+    else if (auto n = dynamic_cast<DimLiteralNode*>(node)) { for (auto& e : n->entries) { add(e.first); add(e.second); } }
+    else if (auto n = dynamic_cast<UnaryOpNode*>(node)) add(n->right);
+    else if (auto n = dynamic_cast<BinaryOpNode*>(node)) { add(n->left); add(n->right); }
+    else if (auto n = dynamic_cast<LogicalOpNode*>(node)) { add(n->left); add(n->right); }
+    else if (auto n = dynamic_cast<TypeConversionNode*>(node)) add(n->expression);
+    else if (auto n = dynamic_cast<AssignmentNode*>(node)) { add(n->target); add(n->value); }
+    else if (auto n = dynamic_cast<CompoundAssignmentNode*>(node)) { add(n->target); add(n->operation->right); }
+    else if (auto n = dynamic_cast<VarDeclarationNode*>(node)) add(n->initializer);
+    else if (auto n = dynamic_cast<IfStatementNode*>(node)) { add(n->condition); add_all(n->then_branch); add_all(n->else_branch); }
+    else if (auto n = dynamic_cast<WhileStatementNode*>(node)) { add(n->condition); add_all(n->do_branch); add_all(n->finally_branch); }
+    else if (auto n = dynamic_cast<LoopForNode*>(node)) { add_all(n->body); add(n->count_expr); }
+    else if (auto n = dynamic_cast<ForInNode*>(node)) { add(n->iterable); add_all(n->body); }
+    else if (auto n = dynamic_cast<LoopUntilNode*>(node)) { add_all(n->body); add(n->condition); }
+    else if (auto n = dynamic_cast<AwaitStatementNode*>(node)) { add(n->condition); add_all(n->then_branch); }
+    else if (auto n = dynamic_cast<SayNode*>(node)) add(n->expression);
+    else if (auto n = dynamic_cast<InpNode*>(node)) add(n->expression);
+    else if (auto n = dynamic_cast<FnDefNode*>(node)) { add_defaults(n->params); add_all(n->body); }
+    else if (auto n = dynamic_cast<CallNode*>(node)) { add(n->callee); add_all(n->arguments); }
+    else if (auto n = dynamic_cast<SubscriptNode*>(node)) { add(n->object); add(n->start); add(n->end); add(n->step); }
+    else if (auto n = dynamic_cast<ReturnNode*>(node)) add(n->value);
+    else if (auto n = dynamic_cast<RaiseNode*>(node)) add(n->expression);
+    else if (auto n = dynamic_cast<TryCatchNode*>(node)) { add_all(n->try_branch); add_all(n->catch_branch); add_all(n->finally_branch); }
+    else if (auto n = dynamic_cast<ClassDefNode*>(node)) { add_defaults(n->fields); add_all(n->initializer_body); add_all(n->methods); }
+    else if (auto n = dynamic_cast<GetNode*>(node)) add(n->object);
+    else if (auto n = dynamic_cast<SetNode*>(node)) { add(n->object); add(n->value); }
+    else if (auto n = dynamic_cast<LambdaNode*>(node)) { add_defaults(n->params); add_all(n->body); }
+    else if (auto n = dynamic_cast<StructDefNode*>(node)) add_defaults(n->fields);
+    else if (auto n = dynamic_cast<SwapNode*>(node)) { add(n->left); add(n->right); }
+    else if (auto n = dynamic_cast<ExpressionStatementNode*>(node)) add(n->expression);
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <map>
+#include <string>
+#include <vector>
+#include "Ast.hpp"
+
+// AST pass run over the main script before it executes. It inlines small
+// functions: a top-level `fn name(...) -> expr`, or a lambda declared once
+// at top level, whose expression reads nothing but its own parameters. Calls
+// to such a name are rewritten into InlinedCallNodes when the name is bound
+// nowhere else in the program and the argument count fits the parameters.
+// It also marks `while` loops that step an integer counter by a constant so
+// they can run the counter unboxed (see WhileStatementNode::run_counted).
+class Optimizer {
+public:
+    static const size_t MAX_INLINE_NODES = 32;
+    void run(std::vector<AstNodePtr>& statements);
+
+private:
+    struct Candidate {
+        const std::vector<ParameterDefinition>* params;
+        AstNodePtr origin; // The ReturnNode that is the function's whole body
+        AstNodePtr expr;   // Its expression with parameters substituted
+    };
+    std::map<std::string, Candidate> candidates;
+    std::map<std::string, int> bindings; // How often each name is bound anywhere
+
+    void consider(const std::string& name, const std::vector<ParameterDefinition>& params, const std::vector<AstNodePtr>& body);
+    void count_bindings(AstNode* node);
+    void rewrite(AstNodePtr& slot);
+    static void mark_counted(WhileStatementNode* loop);
+    static long long step_of(AstNode* stmt, const std::string& name);
+    static AstNodePtr substitute(const AstNodePtr& expr, const std::vector<ParameterDefinition>& params, size_t& budget);
+    static void child_slots(AstNode* node, std::vector<AstNodePtr*>& out);
+};
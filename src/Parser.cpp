@@ -1,11 +1,37 @@
 #include "Parser.hpp"
 #include "msg_cn.hpp"
+#include "Format.hpp"
 
 #ifndef DEBUG
 constexpr bool DEBUG = false;
 #endif
 
-Parser::Parser(const std::string& source) : tokenizer(source), had_error(false) {}
+Parser::Parser(const std::string& source, bool lazy, int first_line)
+    : tokenizer(source, first_line), had_error(false), lazy_bodies(lazy), arena(std::make_shared<AstArena>()) {}
+
+std::vector<AstNodePtr> Parser::parse_body(const std::string& source, int first_line, int& error_line, std::shared_ptr<AstArena>& arena) {
+    Parser parser(source, true, first_line);
+    arena = parser.arena;
+    std::vector<AstNodePtr> body;
+    try {
+        parser.advance();
+        while (parser.current_token.type != TokenType::END_OF_FILE) body.push_back(parser.declaration());
+    } catch (const std::runtime_error&) {
+        error_line = parser.current_token.line;
+        throw;
+    }
+    return body;
+}
+
+ValuePtr Parser::constant(TokenType type, const std::string& lexeme) {
+    ValuePtr& slot = constants[std::string(1, (char)type) + lexeme];
+    if (!slot) {
+        if (type == TokenType::NUMBER) slot = std::make_shared<NumberValue>(BigNumber(lexeme));
+        else if (type == TokenType::STRING) slot = std::make_shared<StringValue>(lexeme);
+        else slot = std::make_shared<BinaryValue>(lexeme);
+    }
+    return slot;
+}
 
 std::vector<AstNodePtr> Parser::parse() {
     if (DEBUG) std::cout << "DEBUG: Starting parse..." << std::endl;
@@ -37,7 +63,7 @@ void Parser::synchronize() {
     advance();
     while (current_token.type != TokenType::END_OF_FILE) {
         switch (current_token.type) {
-            case TokenType::DEC: case TokenType::STR: case TokenType::BIN: case TokenType::LN: case TokenType::DIM: case TokenType::ANY:
+            case TokenType::DEC: case TokenType::STR: case TokenType::BIN: case TokenType::LN: case TokenType::DIM: case TokenType::ANY: case TokenType::F64:
             case TokenType::IF: case TokenType::WHILE: case TokenType::FN: case TokenType::INS: case TokenType::STRUCT:
             case TokenType::SAY: case TokenType::RETURN: case TokenType::TRY: case TokenType::LOOP: case TokenType::AWAIT: case TokenType::USING: case TokenType::RAISE: case TokenType::REQUIRE: case TokenType::EXPOSE: return;
             default: advance();
@@ -49,7 +75,7 @@ AstNodePtr Parser::declaration() {
     if (DEBUG) std::cout << "DEBUG: Parsing declaration '" << current_token.lexeme << ")..." << std::endl;
     if (match({TokenType::REQUIRE})) return require_statement();
     if (match({TokenType::EXPOSE})) return expose_statement();
-    if (match({TokenType::DEC, TokenType::STR, TokenType::BIN, TokenType::LN, TokenType::DIM, TokenType::ANY})) return var_declaration();
+    if (match({TokenType::DEC, TokenType::STR, TokenType::BIN, TokenType::LN, TokenType::DIM, TokenType::ANY, TokenType::F64})) return var_declaration();
     if (match({TokenType::FN})) return fn_definition("function");
     if (match({TokenType::INS})) return class_definition();
     if (match({TokenType::STRUCT})) return struct_definition();
@@ -62,7 +88,7 @@ AstNodePtr Parser::statement() {
     if (match({TokenType::WHILE})) return while_statement();
     if (match({TokenType::LOOP})) return loop_statement();
     if (match({TokenType::BREAK})) return break_statement();
-    if (match({TokenType::CONTINUE})) return std::make_shared<ContinueNode>(previous_token.line);
+    if (match({TokenType::CONTINUE})) return make_node<ContinueNode>(previous_token.line);
     if (match({TokenType::FOR})) return for_in_statement();
     if (match({TokenType::AWAIT})) return await_statement();
     if (match({TokenType::SAY})) return say_statement();
@@ -78,7 +104,7 @@ AstNodePtr Parser::statement() {
 ParameterDefinition Parser::parse_parameter() {
     if (DEBUG) std::cout << "DEBUG: Parsing parameter..." << std::endl;
     Token keyword = current_token;
-    if (!match({TokenType::DEC, TokenType::STR, TokenType::BIN, TokenType::LN, TokenType::DIM, TokenType::ANY})) {
+    if (!match({TokenType::DEC, TokenType::STR, TokenType::BIN, TokenType::LN, TokenType::DIM, TokenType::ANY, TokenType::F64})) {
         throw std::runtime_error(msg(Msg::PARSE_PARAM_TYPE));
     }
     consume(TokenType::IDENTIFIER, msg(Msg::PARSE_PARAM_NAME));
@@ -89,16 +115,17 @@ ParameterDefinition Parser::parse_parameter() {
         if (DEBUG) std::cout << "DEBUG: Parsing default value for '" << param_name << "'..." << std::endl;
         if (check(TokenType::NUMBER)) {
             advance();
-            default_value = std::make_shared<NumberValue>(BigNumber(previous_token.lexeme));
+            if (keyword.type == TokenType::F64) default_value = std::make_shared<F64Value>(std::stod(previous_token.lexeme));
+            else default_value = constant(TokenType::NUMBER, previous_token.lexeme);
         } else if (check(TokenType::STRING)) {
             advance();
-            default_value = std::make_shared<StringValue>(previous_token.lexeme);
+            default_value = constant(TokenType::STRING, previous_token.lexeme);
         } else if (check(TokenType::HEX_LITERAL)) {
             advance();
-            default_value = std::make_shared<BinaryValue>(previous_token.lexeme);
+            default_value = constant(TokenType::HEX_LITERAL, previous_token.lexeme);
         } else if (check(TokenType::NULL_LITERAL)) {
             advance();
-            default_value = std::make_shared<NullValue>();
+            default_value = NullValue::instance();
         } else if (check(TokenType::LBRACKET)) {
             advance();
             if (check(TokenType::RBRACKET)) {
@@ -125,7 +152,7 @@ AstNodePtr Parser::var_declaration() {
     std::string name = previous_token.lexeme;
     AstNodePtr initializer = nullptr;
     if (match({TokenType::EQUAL})) { initializer = expression(); }
-    return std::make_shared<VarDeclarationNode>(keyword.line, keyword, name, initializer);
+    return make_node<VarDeclarationNode>(keyword.line, keyword.type, name, initializer);
 }
 
 AstNodePtr Parser::fn_definition(const std::string& kind) {
@@ -133,6 +160,12 @@ AstNodePtr Parser::fn_definition(const std::string& kind) {
     int line = previous_token.line;
     consume(TokenType::IDENTIFIER, std::string("Expected ") + kind + " name.");
     std::string name = previous_token.lexeme;
+    // `fn memo name(...)` defines a memoized function.
+    bool is_memo = false;
+    if (kind == "function" && name == "memo" && match({TokenType::IDENTIFIER})) {
+        is_memo = true;
+        name = previous_token.lexeme;
+    }
     consume(TokenType::LPAREN, msg(Msg::PARSE_LPAREN_NAME));
     std::vector<ParameterDefinition> params;
     if (!check(TokenType::RPAREN)) {
@@ -145,14 +178,49 @@ AstNodePtr Parser::fn_definition(const std::string& kind) {
     // Shorthand: fn name(params) => expr
     if (match({TokenType::ARROW})) {
         AstNodePtr expr = expression();
-        std::vector<AstNodePtr> body = {std::make_shared<ReturnNode>(line, expr)};
-        return std::make_shared<FnDefNode>(line, name, params, body, kind == "method");
+        std::vector<AstNodePtr> body = {make_node<ReturnNode>(line, expr)};
+        return make_node<FnDefNode>(line, name, params, body, kind == "method", false, is_memo);
     }
     consume(TokenType::DO, msg(Msg::PARSE_DO_BODY));
     std::vector<AstNodePtr> body;
+    if (lazy_bodies) {
+        auto node = make_node<FnDefNode>(line, name, params, body, kind == "method", false, is_memo);
+        node->lazy_body = skip_body();
+        return node;
+    }
     while (!check(TokenType::ENDFN) && !check(TokenType::END) && !check(TokenType::END_OF_FILE)) { body.push_back(declaration()); }
     if (!match({TokenType::ENDFN, TokenType::END})) throw std::runtime_error("Expect 'endfn' or 'end' after function body.");
-    return std::make_shared<FnDefNode>(line, name, params, body, kind == "method");
+    return make_node<FnDefNode>(line, name, params, body, kind == "method", false, is_memo);
+}
+
+// Pre-parse: walks the body's tokens tracking only block nesting, the same
+// way the statement parsers pair openers with `end`, and captures its source.
+std::shared_ptr<LazyBody> Parser::skip_body() {
+    int body_line = current_token.line;
+    size_t begin = tokenizer.token_start();
+    std::vector<TokenType> open = {TokenType::FN};
+    bool fn_header = false; // Inside `fn ...(...)` before its `do` or `->`
+    while (true) {
+        switch (current_token.type) {
+            case TokenType::END_OF_FILE: throw std::runtime_error("Expect 'endfn' or 'end' after function body.");
+            case TokenType::IF: case TokenType::WHILE: case TokenType::LOOP: case TokenType::TRY:
+            case TokenType::AWAIT: case TokenType::INS: open.push_back(current_token.type); break;
+            case TokenType::FN: fn_header = true; break;
+            case TokenType::ARROW: fn_header = false; break;
+            case TokenType::DO: if (fn_header) { open.push_back(TokenType::FN); fn_header = false; } break;
+            // Directly inside a loop body `for`/`until` ends the loop; elsewhere `for` starts a for-in.
+            case TokenType::FOR: if (open.back() == TokenType::LOOP) open.pop_back(); else open.push_back(TokenType::FOR); break;
+            case TokenType::UNTIL: if (open.back() == TokenType::LOOP) open.pop_back(); break;
+            case TokenType::END: case TokenType::ENDFN: case TokenType::ENDIF: case TokenType::ENDWHILE: case TokenType::ENDLOOP:
+            case TokenType::ENDTRY: case TokenType::ENDAWAIT: case TokenType::ENDINS: open.pop_back(); break;
+            default: break;
+        }
+        if (open.empty()) break;
+        advance();
+    }
+    size_t end = tokenizer.token_start();
+    advance();
+    return std::make_shared<LazyBody>(tokenizer.text(begin, end), body_line);
 }
 
 AstNodePtr Parser::fn_lambda(int line) {
@@ -171,15 +239,15 @@ AstNodePtr Parser::fn_lambda(int line) {
     // fn(params) => expr  (lambda / arrow function)
     if (match({TokenType::ARROW})) {
         AstNodePtr expr = expression();
-        std::vector<AstNodePtr> body = {std::make_shared<ReturnNode>(line, expr)};
-        return std::make_shared<LambdaNode>(line, params, body);
+        std::vector<AstNodePtr> body = {make_node<ReturnNode>(line, expr)};
+        return make_node<LambdaNode>(line, params, body);
     }
     // fn(params) do ... endfn  (anonymous function with body)
     consume(TokenType::DO, msg(Msg::PARSE_DO_BODY));
     std::vector<AstNodePtr> body;
     while (!check(TokenType::ENDFN) && !check(TokenType::END) && !check(TokenType::END_OF_FILE)) { body.push_back(declaration()); }
     if (!match({TokenType::ENDFN, TokenType::END})) throw std::runtime_error("Expect 'endfn' or 'end' after function body.");
-    return std::make_shared<LambdaNode>(line, params, body);
+    return make_node<LambdaNode>(line, params, body);
 }
 
 AstNodePtr Parser::class_definition() {
@@ -208,7 +276,7 @@ AstNodePtr Parser::class_definition() {
         else { throw std::runtime_error(msg(Msg::PARSE_ONLY_METHODS)); }
     }
     if (!match({TokenType::ENDINS, TokenType::END})) throw std::runtime_error(msg(Msg::PARSE_ENDINS));
-    return std::make_shared<ClassDefNode>(line, name, fields, initializer_body, methods);
+    return make_node<ClassDefNode>(line, name, fields, initializer_body, methods);
 }
 
 AstNodePtr Parser::struct_definition() {
@@ -225,7 +293,7 @@ AstNodePtr Parser::struct_definition() {
         }
         consume(TokenType::RPAREN, "Expect ')' after struct fields.");
     }
-    return std::make_shared<StructDefNode>(line, name, fields);
+    return make_node<StructDefNode>(line, name, fields);
 }
 
 AstNodePtr Parser::using_statement() {
@@ -235,7 +303,7 @@ AstNodePtr Parser::using_statement() {
     consume(TokenType::AS, "Expect 'as' after variable name in 'using' statement.");
     consume(TokenType::IDENTIFIER, "Expect alias name after 'as'.");
     std::string alias = previous_token.lexeme;
-    return std::make_shared<UsingNode>(line, original, alias);
+    return make_node<UsingNode>(line, original, alias);
 }
 
 AstNodePtr Parser::require_statement() {
@@ -247,7 +315,7 @@ AstNodePtr Parser::require_statement() {
         consume(TokenType::IDENTIFIER, "Expect alias name after 'as' in require statement.");
         alias_name = previous_token.lexeme;
     }
-    return std::make_shared<RequireNode>(line, module_path, alias_name);
+    return make_node<RequireNode>(line, module_path, alias_name);
 }
 
 AstNodePtr Parser::expose_statement() {
@@ -259,7 +327,7 @@ AstNodePtr Parser::expose_statement() {
         }
         return node;
     }
-    if (match({TokenType::DEC, TokenType::STR, TokenType::BIN, TokenType::LN, TokenType::DIM, TokenType::ANY})) {
+    if (match({TokenType::DEC, TokenType::STR, TokenType::BIN, TokenType::LN, TokenType::DIM, TokenType::ANY, TokenType::F64})) {
         auto node = var_declaration();
         if (auto var_node = std::dynamic_pointer_cast<VarDeclarationNode>(node)) {
             var_node->is_exposed = true;
@@ -274,7 +342,7 @@ AstNodePtr Parser::expose_statement() {
         auto node = struct_definition();
         return node;
     }
-    throw std::runtime_error("Expect 'fn', 'dec', 'str', 'bin', 'ln', 'dim', 'any', 'ins', or 'struct' after 'expose'.");
+    throw std::runtime_error("Expect 'fn', 'dec', 'str', 'bin', 'ln', 'dim', 'f64', 'any', 'ins', or 'struct' after 'expose'.");
 }
 
 AstNodePtr Parser::if_statement() {
@@ -292,7 +360,7 @@ AstNodePtr Parser::if_statement() {
         consume(TokenType::THEN, msg(Msg::PARSE_THEN_IF));
         std::vector<AstNodePtr> elif_then;
         while (not_endif()) { elif_then.push_back(declaration()); }
-        auto elif_node = std::make_shared<IfStatementNode>(line, elif_cond, elif_then, std::vector<AstNodePtr>{});
+        auto elif_node = make_node<IfStatementNode>(line, elif_cond, elif_then, std::vector<AstNodePtr>{});
         elif_target->push_back(elif_node);
         // Next elif goes into the else branch of the previous elif_node
         elif_target = &((static_cast<IfStatementNode*>(elif_node.get()))->else_branch);
@@ -306,7 +374,7 @@ AstNodePtr Parser::if_statement() {
         }
     }
     if (!match({TokenType::ENDIF, TokenType::END})) throw std::runtime_error(msg(Msg::PARSE_ENDIF));
-    return std::make_shared<IfStatementNode>(line, condition, then_branch, else_branch);
+    return make_node<IfStatementNode>(line, condition, then_branch, else_branch);
 }
 
 AstNodePtr Parser::while_statement() {
@@ -318,7 +386,7 @@ AstNodePtr Parser::while_statement() {
     std::vector<AstNodePtr> finally_branch;
     if (match({TokenType::FINALLY, TokenType::FIN})) { while (!check(TokenType::ENDWHILE) && !check(TokenType::END) && !check(TokenType::END_OF_FILE)) { finally_branch.push_back(declaration()); } }
     if (!match({TokenType::ENDWHILE, TokenType::END})) throw std::runtime_error(msg(Msg::PARSE_ENDWHILE));
-    return std::make_shared<WhileStatementNode>(line, condition, do_branch, finally_branch);
+    return make_node<WhileStatementNode>(line, condition, do_branch, finally_branch);
 }
 
 AstNodePtr Parser::loop_statement() {
@@ -336,18 +404,18 @@ AstNodePtr Parser::loop_statement() {
     if (match({TokenType::FOR})) {
         AstNodePtr count_expr = expression();
         consume(TokenType::TIMES, "Expect 'times' after 'for' loop count.");
-        return std::make_shared<LoopForNode>(line, index_var_name, body, count_expr);
+        return make_node<LoopForNode>(line, index_var_name, body, count_expr);
     } else if (match({TokenType::UNTIL})) {
         AstNodePtr condition = expression();
-        return std::make_shared<LoopUntilNode>(line, index_var_name, body, condition);
+        return make_node<LoopUntilNode>(line, index_var_name, body, condition);
     } else if (match({TokenType::ENDLOOP, TokenType::END})) {
-        return std::make_shared<LoopUntilNode>(line, index_var_name, body, nullptr);
+        return make_node<LoopUntilNode>(line, index_var_name, body, nullptr);
     } else {
         throw std::runtime_error("Unterminated 'loop' block. Expect 'for', 'until', or 'endloop'.");
     }
 }
 
-AstNodePtr Parser::break_statement() { return std::make_shared<BreakNode>(previous_token.line); }
+AstNodePtr Parser::break_statement() { return make_node<BreakNode>(previous_token.line); }
 
 AstNodePtr Parser::await_statement() {
     int line = previous_token.line;
@@ -356,7 +424,7 @@ AstNodePtr Parser::await_statement() {
     std::vector<AstNodePtr> then_branch;
     while (!check(TokenType::ENDAWAIT) && !check(TokenType::END) && !check(TokenType::END_OF_FILE)) { then_branch.push_back(declaration()); }
     if (!match({TokenType::ENDAWAIT, TokenType::END})) throw std::runtime_error(msg(Msg::PARSE_ENDAWAIT));
-    return std::make_shared<AwaitStatementNode>(line, condition, then_branch);
+    return make_node<AwaitStatementNode>(line, condition, then_branch);
 }
 
 AstNodePtr Parser::try_statement() {
@@ -371,7 +439,22 @@ AstNodePtr Parser::try_statement() {
     std::vector<AstNodePtr> finally_branch;
     if (match({TokenType::FINALLY, TokenType::FIN})) { while (!check(TokenType::ENDTRY) && !check(TokenType::END) && !check(TokenType::END_OF_FILE)) { finally_branch.push_back(declaration()); } }
     if (!match({TokenType::ENDTRY, TokenType::END})) throw std::runtime_error(msg(Msg::PARSE_ENDTRY));
-    return std::make_shared<TryCatchNode>(line, try_branch, exception_var, catch_branch, finally_branch);
+    auto node = make_node<TryCatchNode>(line, try_branch, exception_var, catch_branch, finally_branch);
+    node->try_scoped = declares_names(try_branch);
+    node->finally_scoped = declares_names(finally_branch);
+    return node;
+}
+
+// True if running `block` binds a name in its own scope. Nested blocks get
+// their own environments, so only the block's direct statements count.
+bool Parser::declares_names(const std::vector<AstNodePtr>& block) {
+    for (const auto& stmt : block) {
+        AstNode* node = stmt.get();
+        if (dynamic_cast<VarDeclarationNode*>(node) || dynamic_cast<FnDefNode*>(node) ||
+            dynamic_cast<ClassDefNode*>(node) || dynamic_cast<StructDefNode*>(node) ||
+            dynamic_cast<UsingNode*>(node) || dynamic_cast<RequireNode*>(node)) return true;
+    }
+    return false;
 }
 
 AstNodePtr Parser::for_in_statement() {
@@ -384,26 +467,26 @@ AstNodePtr Parser::for_in_statement() {
     std::vector<AstNodePtr> body;
     while (!check(TokenType::END) && !check(TokenType::END_OF_FILE)) { body.push_back(declaration()); }
     if (!match({TokenType::END})) throw std::runtime_error("Expect 'end' after for-in body.");
-    return std::make_shared<ForInNode>(line, var_name, iterable, body);
+    return make_node<ForInNode>(line, var_name, iterable, body);
 }
 
-AstNodePtr Parser::raise_statement() { int line = previous_token.line; return std::make_shared<RaiseNode>(line, expression()); }
+AstNodePtr Parser::raise_statement() { int line = previous_token.line; return make_node<RaiseNode>(line, expression()); }
 AstNodePtr Parser::say_statement() {
     int line = previous_token.line;
     consume(TokenType::LPAREN, msg(Msg::PARSE_LPAREN_SAY));
     AstNodePtr value = expression();
     consume(TokenType::RPAREN, msg(Msg::PARSE_RPAREN_EXPR));
-    return std::make_shared<SayNode>(line, value);
+    return make_node<SayNode>(line, value);
 }
 
 AstNodePtr Parser::return_statement() {
     int line = previous_token.line;
     ValuePtr v = std::make_shared<NullValue>();
-    AstNodePtr val_node = std::make_shared<LiteralNode>(line, v);
+    AstNodePtr val_node = make_node<LiteralNode>(line, v);
     if (!check(TokenType::ENDFN) && !check(TokenType::ENDIF) && !check(TokenType::ENDWHILE) && !check(TokenType::ENDTRY) && !check(TokenType::END) && !check(TokenType::ELIF) && !check(TokenType::ELSE)) {
         val_node = expression();
     }
-    return std::make_shared<ReturnNode>(line, val_node);
+    return make_node<ReturnNode>(line, val_node);
 }
 
 AstNodePtr Parser::swap_statement() {
@@ -420,12 +503,12 @@ AstNodePtr Parser::swap_statement() {
     if (!dynamic_cast<VariableNode*>(right_arg.get()) && !dynamic_cast<SubscriptNode*>(right_arg.get())) {
         throw std::runtime_error("Second argument to swap must be an assignable variable or list element.");
     }
-    return std::make_shared<SwapNode>(line, left_arg, right_arg);
+    return make_node<SwapNode>(line, left_arg, right_arg);
 }
 
 AstNodePtr Parser::expression_statement() {
     int line = current_token.line;
-    return std::make_shared<ExpressionStatementNode>(line, expression());
+    return make_node<ExpressionStatementNode>(line, expression());
 }
 
 AstNodePtr Parser::expression() { return assignment(); }
@@ -444,16 +527,15 @@ AstNodePtr Parser::assignment() {
                 throw std::runtime_error(msg(Msg::INVALID_ASSIGN));
             }
             AstNodePtr right = assignment();
-            Token op_token = {binary_ops[i], "", line};
-            auto binary = std::make_shared<BinaryOpNode>(line, expr, op_token, right);
-            return std::make_shared<AssignmentNode>(line, expr, binary);
+            auto operation = make_node<BinaryOpNode>(line, expr, binary_ops[i], right);
+            return make_node<CompoundAssignmentNode>(line, expr, operation);
         }
     }
     if (match({TokenType::EQUAL})) {
         int line = previous_token.line;
         AstNodePtr value = assignment();
         if (dynamic_cast<VariableNode*>(expr.get()) || dynamic_cast<SubscriptNode*>(expr.get()) || dynamic_cast<GetNode*>(expr.get())) {
-            return std::make_shared<AssignmentNode>(line, expr, value);
+            return make_node<AssignmentNode>(line, expr, value);
         }
         throw std::runtime_error(msg(Msg::INVALID_ASSIGN));
     }
@@ -464,7 +546,7 @@ AstNodePtr Parser::logical_or() {
     AstNodePtr expr = logical_and();
     while (match({TokenType::OR})) {
         Token op = previous_token;
-        expr = std::make_shared<LogicalOpNode>(op.line, expr, op, logical_and());
+        expr = make_node<LogicalOpNode>(op.line, expr, op.type, logical_and());
     }
     return expr;
 }
@@ -473,7 +555,7 @@ AstNodePtr Parser::logical_and() {
     AstNodePtr expr = equality();
     while (match({TokenType::AND})) {
         Token op = previous_token;
-        expr = std::make_shared<LogicalOpNode>(op.line, expr, op, equality());
+        expr = make_node<LogicalOpNode>(op.line, expr, op.type, equality());
     }
     return expr;
 }
@@ -482,7 +564,7 @@ AstNodePtr Parser::equality() {
     AstNodePtr expr = comparison();
     while (match({TokenType::EQUAL_EQUAL, TokenType::BANG_EQUAL})) {
         Token op = previous_token;
-        expr = std::make_shared<BinaryOpNode>(op.line, expr, op, comparison());
+        expr = make_node<BinaryOpNode>(op.line, expr, op.type, comparison());
     }
     return expr;
 }
@@ -491,7 +573,7 @@ AstNodePtr Parser::comparison() {
     AstNodePtr expr = term();
     while (match({TokenType::GREATER, TokenType::GREATER_EQUAL, TokenType::LESS, TokenType::LESS_EQUAL})) {
         Token op = previous_token;
-        expr = std::make_shared<BinaryOpNode>(op.line, expr, op, term());
+        expr = make_node<BinaryOpNode>(op.line, expr, op.type, term());
     }
     return expr;
 }
@@ -500,7 +582,7 @@ AstNodePtr Parser::term() {
     AstNodePtr expr = factor();
     while (match({TokenType::PLUS, TokenType::MINUS})) {
         Token op = previous_token;
-        expr = std::make_shared<BinaryOpNode>(op.line, expr, op, factor());
+        expr = make_node<BinaryOpNode>(op.line, expr, op.type, factor());
     }
     return expr;
 }
@@ -509,7 +591,7 @@ AstNodePtr Parser::factor() {
     AstNodePtr expr = power();
     while (match({TokenType::STAR, TokenType::SLASH, TokenType::MODULO})) {
         Token op = previous_token;
-        expr = std::make_shared<BinaryOpNode>(op.line, expr, op, power());
+        expr = make_node<BinaryOpNode>(op.line, expr, op.type, power());
     }
     return expr;
 }
@@ -518,7 +600,7 @@ AstNodePtr Parser::power() {
     AstNodePtr expr = typecast();
     while (match({TokenType::CARET})) {
         Token op = previous_token;
-        expr = std::make_shared<BinaryOpNode>(op.line, expr, op, typecast());
+        expr = make_node<BinaryOpNode>(op.line, expr, op.type, typecast());
     }
     return expr;
 }
@@ -527,10 +609,10 @@ AstNodePtr Parser::typecast() {
     AstNodePtr expr = unary();
     if (match({TokenType::AS})) {
         int line = previous_token.line;
-            if (match({TokenType::DEC, TokenType::STR, TokenType::BIN, TokenType::LN, TokenType::DIM})) {
-            return std::make_shared<TypeConversionNode>(line, expr, previous_token);
+            if (match({TokenType::DEC, TokenType::STR, TokenType::BIN, TokenType::LN, TokenType::DIM, TokenType::F64})) {
+            return make_node<TypeConversionNode>(line, expr, previous_token.type);
         } else {
-            throw std::runtime_error("Expect 'dec', 'str', 'bin', 'ln', or 'dim' after 'as' for type conversion.");
+            throw std::runtime_error("Expect 'dec', 'str', 'bin', 'ln', 'dim', or 'f64' after 'as' for type conversion.");
         }
     }
     return expr;
@@ -539,7 +621,7 @@ AstNodePtr Parser::typecast() {
 AstNodePtr Parser::unary() {
     if (match({TokenType::NOT, TokenType::MINUS})) {
         Token op = previous_token;
-        return std::make_shared<UnaryOpNode>(op.line, op, unary());
+        return make_node<UnaryOpNode>(op.line, op.type, unary());
     }
     return call();
 }
@@ -552,7 +634,7 @@ AstNodePtr Parser::call() {
         else if (match({TokenType::DOT})) {
             consume(TokenType::IDENTIFIER, msg(Msg::PARSE_PROP_NAME));
             std::string name = previous_token.lexeme;
-            expr = std::make_shared<GetNode>(previous_token.line, expr, name);
+            expr = make_node<GetNode>(previous_token.line, expr, name);
         } else { break; }
     }
     return expr;
@@ -568,7 +650,7 @@ AstNodePtr Parser::finish_call(AstNodePtr callee) {
         } while (match({TokenType::COMMA}));
     }
     consume(TokenType::RPAREN, msg(Msg::PARSE_RPAREN_PARAMS));
-    return std::make_shared<CallNode>(line, callee, arguments);
+    return make_node<CallNode>(line, callee, arguments);
 }
 
 AstNodePtr Parser::finish_subscript(AstNodePtr object) {
@@ -579,10 +661,10 @@ AstNodePtr Parser::finish_subscript(AstNodePtr object) {
         if (!check(TokenType::COLON) && !check(TokenType::RBRACKET)) { part2 = expression(); }
         if (match({TokenType::COLON})) { if (!check(TokenType::RBRACKET)) { part3 = expression(); } }
         consume(TokenType::RBRACKET, msg(Msg::PARSE_RBRACKET_IDX));
-        return std::make_shared<SubscriptNode>(line, object, part1, part2, part3, true);
+        return make_node<SubscriptNode>(line, object, part1, part2, part3, true);
     } else {
         consume(TokenType::RBRACKET, msg(Msg::PARSE_RBRACKET_IDX));
-        return std::make_shared<SubscriptNode>(line, object, part1, nullptr, nullptr, false);
+        return make_node<SubscriptNode>(line, object, part1, nullptr, nullptr, false);
     }
 }
 
@@ -593,7 +675,7 @@ AstNodePtr Parser::list_literal() {
         do { elements.push_back(expression()); } while (match({TokenType::COMMA}));
     }
     consume(TokenType::RBRACKET, msg(Msg::PARSE_RBRACKET_LN));
-    return std::make_shared<ListLiteralNode>(line, elements);
+    return make_node<ListLiteralNode>(line, elements);
 }
 
 AstNodePtr Parser::dim_literal() {
@@ -608,29 +690,46 @@ AstNodePtr Parser::dim_literal() {
         } while (match({TokenType::COMMA}));
     }
     consume(TokenType::RBRACE, "Expect '}' after dim literal.");
-    return std::make_shared<DimLiteralNode>(line, entries);
+    return make_node<DimLiteralNode>(line, entries);
+}
+
+// Each `{expr}` of an f-string is parsed by a sub-parser over the field text
+// that allocates into this parse's arena.
+AstNodePtr Parser::format_string(int line, const std::string& text) {
+    std::vector<AstNodePtr> args;
+    auto format = std::make_shared<FormatTemplate>(FormatTemplate::compile(text, [&](const std::string& field) {
+        Parser field_parser(field, false, line);
+        field_parser.arena = arena;
+        field_parser.advance();
+        if (field_parser.check(TokenType::END_OF_FILE)) throw std::runtime_error(msg(Msg::PARSE_EXPR));
+        args.push_back(field_parser.expression());
+        if (!field_parser.check(TokenType::END_OF_FILE)) throw std::runtime_error(msg(Msg::FORMAT_BRACE));
+        return args.size() - 1;
+    }));
+    return make_node<FormatStringNode>(line, format, args);
 }
 
 AstNodePtr Parser::primary() {
     int line = current_token.line;
     if (match({TokenType::FN})) return fn_lambda(line);
-    if (match({TokenType::NUMBER})) return std::make_shared<LiteralNode>(line, std::make_shared<NumberValue>(BigNumber(previous_token.lexeme)));
-    if (match({TokenType::STRING})) return std::make_shared<LiteralNode>(line, std::make_shared<StringValue>(previous_token.lexeme));
-    if (match({TokenType::HEX_LITERAL})) return std::make_shared<LiteralNode>(line, std::make_shared<BinaryValue>(previous_token.lexeme));
-    if (match({TokenType::NULL_LITERAL})) return std::make_shared<LiteralNode>(line, std::make_shared<NullValue>());
+    if (match({TokenType::NUMBER})) return make_node<LiteralNode>(line, constant(TokenType::NUMBER, previous_token.lexeme));
+    if (match({TokenType::STRING})) return make_node<LiteralNode>(line, constant(TokenType::STRING, previous_token.lexeme));
+    if (match({TokenType::HEX_LITERAL})) return make_node<LiteralNode>(line, constant(TokenType::HEX_LITERAL, previous_token.lexeme));
+    if (match({TokenType::FSTRING})) return format_string(line, previous_token.lexeme);
+    if (match({TokenType::NULL_LITERAL})) return make_node<LiteralNode>(line, NullValue::instance());
     if (match({TokenType::LBRACKET})) return list_literal();
     if (match({TokenType::LBRACE})) return dim_literal();
-    if (match({TokenType::IDENTIFIER})) return std::make_shared<VariableNode>(line, previous_token.lexeme);
+    if (match({TokenType::IDENTIFIER})) return make_node<VariableNode>(line, previous_token.lexeme);
     if (match({TokenType::ASK})) {
         consume(TokenType::LPAREN, msg(Msg::PARSE_LPAREN_ASK));
         AstNodePtr prompt = expression();
         consume(TokenType::RPAREN, msg(Msg::PARSE_RPAREN_PROMPT));
-        auto ask_node = std::make_shared<InpNode>(line, prompt);
+        auto ask_node = make_node<InpNode>(line, prompt);
         if (match({TokenType::AS})) {
             consume(TokenType::IDENTIFIER, "Expect variable name for assignment after 'as'.");
             std::string var_name = previous_token.lexeme;
-            auto var_node = std::make_shared<VariableNode>(previous_token.line, var_name);
-            return std::make_shared<AssignmentNode>(line, var_node, ask_node);
+            auto var_node = make_node<VariableNode>(previous_token.line, var_name);
+            return make_node<AssignmentNode>(line, var_node, ask_node);
         }
         return ask_node;
     }
@@ -3,18 +3,39 @@
 #include <vector>
 #include <memory>
 #include <stdexcept>
+#include <unordered_map>
+#include <utility>
 #include "Tokenizer.hpp"
 #include "Ast.hpp"
 
 class Parser {
 public:
-    Parser(const std::string& source);
+    // With lazy_bodies set, named function and method bodies are only
+    // scanned for their matching `end` and parsed on first call.
+    Parser(const std::string& source, bool lazy_bodies = false, int first_line = 1);
     std::vector<AstNodePtr> parse();
+    // Parses a lazily skipped body into a fresh arena, returned in `arena`.
+    // Throws std::runtime_error on the first syntax error, with error_line set
+    // to where it was found.
+    static std::vector<AstNodePtr> parse_body(const std::string& source, int first_line, int& error_line, std::shared_ptr<AstArena>& arena);
     bool has_error() const { return had_error; }
+    // Memory of the nodes this parser built; it must outlive all of them.
+    const std::shared_ptr<AstArena>& node_arena() const { return arena; }
 private:
     Tokenizer tokenizer;
     Token current_token, previous_token;
     bool had_error;
+    bool lazy_bodies;
+    std::shared_ptr<AstArena> arena;
+    // Literal values already built during this parse, keyed by kind and
+    // lexeme, so repeated constants share one immutable value.
+    std::unordered_map<std::string, ValuePtr> constants;
+
+    template <class T, class... Args>
+    std::shared_ptr<T> make_node(Args&&... args) {
+        return std::allocate_shared<T>(ArenaAllocator<T>(arena.get()), std::forward<Args>(args)...);
+    }
+    ValuePtr constant(TokenType type, const std::string& lexeme);
 
     void advance();
     void consume(TokenType type, const std::string& msg);
@@ -28,6 +49,7 @@ private:
     ParameterDefinition parse_parameter();
     AstNodePtr var_declaration();
     AstNodePtr fn_definition(const std::string& kind);
+    std::shared_ptr<LazyBody> skip_body();
     AstNodePtr class_definition();
     AstNodePtr struct_definition();
     AstNodePtr using_statement();
@@ -62,5 +84,7 @@ private:
     AstNodePtr finish_subscript(AstNodePtr object);
     AstNodePtr list_literal();
     AstNodePtr dim_literal();
+    AstNodePtr format_string(int line, const std::string& text);
     AstNodePtr primary();
+    static bool declares_names(const std::vector<AstNodePtr>& block);
 };
@@ -0,0 +1,94 @@
+#pragma once
+#include <cstdint>
+#include <chrono>
+#include <vector>
+#include "BigNumber.hpp"
+
+// xoshiro256** generator behind the random natives. One process-wide instance
+// is seeded from the clock at startup and can be reseeded for reproducible runs.
+class Random {
+private:
+    uint64_t s[4];
+
+    static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+    static uint64_t splitmix64(uint64_t& x) {
+        uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+public:
+    explicit Random(uint64_t seed_value) { seed(seed_value); }
+
+    static Random& global() {
+        static Random instance((uint64_t)std::chrono::high_resolution_clock::now().time_since_epoch().count());
+        return instance;
+    }
+
+    void seed(uint64_t seed_value) {
+        for (int i = 0; i < 4; ++i) s[i] = splitmix64(seed_value);
+    }
+
+    uint64_t next() {
+        uint64_t result = rotl(s[1] * 5, 7) * 9;
+        uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+
+    // Uniform in [0, 1) with all 53 mantissa bits random.
+    double uniform() { return (next() >> 11) * (1.0 / 9007199254740992.0); }
+
+    // Uniform in [0, bound) by rejecting the biased tail of the 64-bit range.
+    uint64_t below(uint64_t bound) {
+        uint64_t threshold = (0 - bound) % bound;
+        uint64_t r;
+        do { r = next(); } while (r < threshold);
+        return r % bound;
+    }
+
+    // Uniform in [0, 10^n), written directly as base-MOD limbs. With
+    // leading_digit set the result has exactly n digits instead.
+    BigNumberDetail::UnsignedDigit decimal_digits(int n, bool leading_digit = false) {
+        BigNumberDetail::UnsignedDigit ret;
+        if (n <= 0) return ret;
+        int limbs = (n + BigNumberDetail::BASE - 1) / BigNumberDetail::BASE;
+        int top = BigNumberDetail::POW10[n - (limbs - 1) * BigNumberDetail::BASE - 1];
+        ret.digits.resize(limbs);
+        for (int i = 0; i + 1 < limbs; ++i) ret.digits[i] = (int)below(BigNumberDetail::MOD);
+        ret.digits[limbs - 1] = leading_digit ? top + (int)below(9ULL * top) : (int)below(10ULL * top);
+        ret.trim();
+        return ret;
+    }
+
+    // Uniform integer in [lo, hi]. Spans past 10^15 draw decimal
+    // digits and reject values past the range.
+    BigNumber between(const BigNumber& lo, const BigNumber& hi) {
+        BigNumber span = hi - lo + BigNumber(1);
+        long long small;
+        if (span.toSmallInt(small)) return lo + BigNumber((long long)below((uint64_t)small));
+        int n = span.toString().size();
+        BigNumber r;
+        do { r = BigNumber(decimal_digits(n), false, 0); } while (r >= span);
+        return lo + r;
+    }
+
+    void fill_bytes(std::vector<uint8_t>& out) {
+        size_t i = 0;
+        for (; i + 8 <= out.size(); i += 8) {
+            uint64_t r = next();
+            for (int k = 0; k < 8; ++k) out[i + k] = (uint8_t)(r >> (8 * k));
+        }
+        if (i < out.size()) {
+            uint64_t r = next();
+            for (; i < out.size(); ++i, r >>= 8) out[i] = (uint8_t)r;
+        }
+    }
+};
@@ -0,0 +1,107 @@
+#pragma once
+#include <string>
+#include <stdexcept>
+#include "BigNumber.hpp"
+
+// Exact fraction num/den in lowest terms, den > 0. Decimal digits are only
+// produced when the value is rendered, so chains like a / 3 * 3 stay exact.
+class Rational {
+public:
+    typedef BigNumberDetail::UnsignedDigit Digits;
+
+    // When set, dividing two decs yields a Rational instead of rounding.
+    static bool& exact_mode_ref() {
+        static bool exact_mode = false;
+        return exact_mode;
+    }
+    static bool exact_mode() { return exact_mode_ref(); }
+
+    Rational() : negative(false), num(0LL), den(1LL) {}
+    // Exact: a decimal is magnitude / 10^decimal_pos.
+    explicit Rational(const BigNumber& n) : negative(n.is_negative), num(n.magnitude), den(1) {
+        den.scale10_in_place(n.decimal_pos);
+        reduce();
+    }
+    Rational(Digits n, Digits d, bool neg) : negative(neg), num(std::move(n)), den(std::move(d)) {
+        if (den.isZero()) throw std::runtime_error("Division by zero.");
+        reduce();
+    }
+
+    static Rational divide(const BigNumber& a, const BigNumber& b) {
+        if (b.magnitude.isZero()) throw std::runtime_error("Division by zero.");
+        int dec = std::max(a.decimal_pos, b.decimal_pos);
+        return Rational(a.scaled_magnitude(dec), b.scaled_magnitude(dec), a.is_negative != b.is_negative);
+    }
+
+    Rational operator+(const Rational& o) const { return add(o, o.negative); }
+    Rational operator-(const Rational& o) const { return add(o, !o.negative); }
+    Rational operator*(const Rational& o) const { return Rational(num * o.num, den * o.den, negative != o.negative); }
+    Rational operator/(const Rational& o) const {
+        if (o.num.isZero()) throw std::runtime_error("Division by zero.");
+        return Rational(num * o.den, den * o.num, negative != o.negative);
+    }
+    // Same rules as BigNumber::operator%: integers only, and the remainder
+    // carries the sign of *this.
+    Rational operator%(const Rational& o) const {
+        if (!isInteger() || !o.isInteger()) throw std::runtime_error("Operands for modulo must be integers.");
+        if (o.num.isZero()) throw std::runtime_error("Modulo by zero.");
+        return Rational(num - (num / o.num) * o.num, Digits(1), negative);
+    }
+    Rational pow(long long e) const {
+        if (e < 0) return Rational(Digits(1), Digits(1), false) / pow(-e);
+        // Powers of a reduced fraction stay reduced.
+        Rational r(*this);
+        r.num = BigNumberDetail::pow(num, e);
+        r.den = BigNumberDetail::pow(den, e);
+        r.negative = negative && (e % 2 != 0) && !r.num.isZero();
+        return r;
+    }
+
+    int compare(const Rational& o) const {
+        if (negative != o.negative) return negative ? -1 : 1;
+        Digits l = num * o.den, r = o.num * den;
+        int c = (l < r) ? -1 : (r < l) ? 1 : 0;
+        return negative ? -c : c;
+    }
+    bool isZero() const { return num.isZero(); }
+    bool isInteger() const { return den == Digits(1); }
+
+    // Rounded exactly like BigNumber::operator/ at the given precision.
+    BigNumber toBigNumber(int precision) const {
+        if (isInteger()) return BigNumber(num, negative, 0);
+        Digits scaled = num;
+        scaled.scale10_in_place(precision + 5);
+        return BigNumber(scaled / den, negative, precision + 5).approx(precision);
+    }
+    BigNumber toBigNumber() const { return toBigNumber(BigNumber::get_default_precision()); }
+    std::string toString() const { return toBigNumber().toString(); }
+
+private:
+    bool negative;
+    Digits num, den;
+
+    Rational add(const Rational& o, bool o_negative) const {
+        Digits l = num * o.den, r = o.num * den;
+        if (negative == o_negative) return Rational(l + r, den * o.den, negative);
+        if (r <= l) return Rational(l - r, den * o.den, negative);
+        return Rational(r - l, den * o.den, o_negative);
+    }
+
+    void reduce() {
+        if (num.isZero()) {
+            negative = false;
+            den = Digits(1);
+            return;
+        }
+        Digits a = num, b = den, q, r;
+        while (!b.isZero()) {
+            a.divmod(b, q, r);
+            swap(a, b);
+            swap(b, r);
+        }
+        if (!(a == Digits(1))) {
+            num = num / a;
+            den = den / a;
+        }
+    }
+};
@@ -0,0 +1,160 @@
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <vector>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Byte-level search and case/whitespace helpers for the string natives.
+// Offsets are byte offsets into the UTF-8 text; npos means not found.
+namespace StringOps {
+
+    const size_t npos = std::string::npos;
+
+#if defined(__SSE2__)
+    // Needles of two or more bytes: each 16-byte block is tested for positions
+    // where both the needle's first and last byte match, and only those
+    // candidates are compared in full.
+    inline size_t find_sse2(const char* hay, size_t n, const char* needle, size_t m, size_t from) {
+        const __m128i first = _mm_set1_epi8(needle[0]);
+        const __m128i last = _mm_set1_epi8(needle[m - 1]);
+        size_t i = from;
+        for (; i + m - 1 + 16 <= n; i += 16) {
+            __m128i block_first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(hay + i));
+            __m128i block_last = _mm_loadu_si128(reinterpret_cast<const __m128i*>(hay + i + m - 1));
+            unsigned mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(block_first, first), _mm_cmpeq_epi8(block_last, last)));
+            while (mask) {
+                unsigned bit = __builtin_ctz(mask);
+                if (std::memcmp(hay + i + bit + 1, needle + 1, m - 2) == 0) return i + bit;
+                mask &= mask - 1;
+            }
+        }
+        for (; i + m <= n; ++i) {
+            if (hay[i] == needle[0] && std::memcmp(hay + i + 1, needle + 1, m - 1) == 0) return i;
+        }
+        return npos;
+    }
+#endif
+
+    // First occurrence of `needle` in `hay` at or after `from`.
+    inline size_t find(const std::string& hay, const std::string& needle, size_t from = 0) {
+        size_t n = hay.size(), m = needle.size();
+        if (from > n || m > n - from) return npos;
+        if (m == 0) return from;
+        if (m == 1) {
+            const void* p = std::memchr(hay.data() + from, needle[0], n - from);
+            return p ? static_cast<const char*>(p) - hay.data() : npos;
+        }
+#if defined(__SSE2__)
+        return find_sse2(hay.data(), n, needle.data(), m, from);
+#else
+        return hay.find(needle, from);
+#endif
+    }
+
+    // Non-overlapping occurrences of a non-empty `needle`.
+    inline size_t count(const std::string& hay, const std::string& needle) {
+        size_t total = 0;
+        for (size_t pos = find(hay, needle); pos != npos; pos = find(hay, needle, pos + needle.size())) ++total;
+        return total;
+    }
+
+    // Pieces of `s` between occurrences of a non-empty `sep`. Match positions
+    // are collected first so the result is sized once.
+    inline std::vector<std::string> split(const std::string& s, const std::string& sep) {
+        std::vector<size_t> cuts;
+        for (size_t pos = find(s, sep); pos != npos; pos = find(s, sep, pos + sep.size())) cuts.push_back(pos);
+        std::vector<std::string> parts;
+        parts.reserve(cuts.size() + 1);
+        size_t begin = 0;
+        for (size_t pos : cuts) {
+            parts.emplace_back(s, begin, pos - begin);
+            begin = pos + sep.size();
+        }
+        parts.emplace_back(s, begin, npos);
+        return parts;
+    }
+
+    // UTF-8 lead or single bytes start a code point; 10xxxxxx bytes continue one.
+    inline bool starts_code_point(char c) { return (static_cast<unsigned char>(c) & 0xC0) != 0x80; }
+
+    inline bool is_ascii(const char* p, size_t n) {
+        size_t i = 0;
+#if defined(__SSE2__)
+        __m128i any = _mm_setzero_si128();
+        for (; i + 16 <= n; i += 16) any = _mm_or_si128(any, _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i)));
+        if (_mm_movemask_epi8(any)) return false;
+#endif
+        for (; i < n; ++i) if (static_cast<unsigned char>(p[i]) >= 0x80) return false;
+        return true;
+    }
+
+    // Code points in p[0, n), counted 16 bytes at a time: a byte starts a code
+    // point exactly when, read as signed, it is greater than -65 (0xBF).
+    inline size_t count_code_points(const char* p, size_t n) {
+        size_t count = 0, i = 0;
+#if defined(__SSE2__)
+        const __m128i continuation_max = _mm_set1_epi8(-65);
+        for (; i + 16 <= n; i += 16) {
+            __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+            count += __builtin_popcount(_mm_movemask_epi8(_mm_cmpgt_epi8(block, continuation_max)));
+        }
+#endif
+        for (; i < n; ++i) count += starts_code_point(p[i]);
+        return count;
+    }
+
+    inline bool is_space(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v'; }
+
+    // Pieces of `s` separated by runs of whitespace; empty pieces are dropped.
+    inline std::vector<std::string> split_whitespace(const std::string& s) {
+        std::vector<std::string> parts;
+        size_t i = 0, n = s.size();
+        while (true) {
+            while (i < n && is_space(s[i])) ++i;
+            if (i == n) break;
+            size_t begin = i;
+            while (i < n && !is_space(s[i])) ++i;
+            parts.emplace_back(s, begin, i - begin);
+        }
+        return parts;
+    }
+
+    // Every occurrence of a non-empty `from` replaced by `to`, built in a
+    // buffer of the exact final size.
+    inline std::string replace(const std::string& s, const std::string& from, const std::string& to) {
+        std::vector<size_t> hits;
+        for (size_t pos = find(s, from); pos != npos; pos = find(s, from, pos + from.size())) hits.push_back(pos);
+        if (hits.empty()) return s;
+        std::string out;
+        out.reserve(s.size() - hits.size() * from.size() + hits.size() * to.size());
+        size_t begin = 0;
+        for (size_t pos : hits) {
+            out.append(s, begin, pos - begin);
+            out += to;
+            begin = pos + from.size();
+        }
+        out.append(s, begin, npos);
+        return out;
+    }
+
+    inline std::string strip(const std::string& s) {
+        size_t begin = 0, end = s.size();
+        while (begin < end && is_space(s[begin])) ++begin;
+        while (end > begin && is_space(s[end - 1])) --end;
+        return s.substr(begin, end - begin);
+    }
+
+    // ASCII letters only; other bytes, including UTF-8 sequences, are kept.
+    inline std::string to_upper(std::string s) {
+        for (char& c : s) if (c >= 'a' && c <= 'z') c -= 'a' - 'A';
+        return s;
+    }
+    inline std::string to_lower(std::string s) {
+        for (char& c : s) if (c >= 'A' && c <= 'Z') c += 'a' - 'A';
+        return s;
+    }
+
+} // namespace StringOps
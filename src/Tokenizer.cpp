@@ -1,9 +1,10 @@
 #include "Tokenizer.hpp"
 #include "msg_cn.hpp"
 
-Tokenizer::Tokenizer(const std::string& source) : source(source), start(0), current(0), line(1) {
+Tokenizer::Tokenizer(const std::string& source, int first_line) : source(source), start(0), current(0), line(first_line) {
     keywords["any"] = TokenType::ANY;
     keywords["dim"] = TokenType::DIM;
+    keywords["f64"] = TokenType::F64;
     keywords["nul"] = TokenType::NULL_LITERAL;
     keywords["dec"] = TokenType::DEC; keywords["str"] = TokenType::STR; keywords["bin"] = TokenType::BIN; keywords["ln"] = TokenType::LN;
     keywords["if"] = TokenType::IF; keywords["then"] = TokenType::THEN; keywords["else"] = TokenType::ELSE; keywords["elif"] = TokenType::ELIF; keywords["endif"] = TokenType::ENDIF; keywords["end"] = TokenType::END;
@@ -36,7 +37,7 @@ Token Tokenizer::next_token() {
         case '^': return make_token(match('=') ? TokenType::CARET_EQUAL : TokenType::CARET);
         case '%': return make_token(match('=') ? TokenType::MODULO_EQUAL : TokenType::MODULO);
         case '=': return make_token(match('=') ? TokenType::EQUAL_EQUAL : TokenType::EQUAL);
-        case '-': return make_token(match('>') ? TokenType::ARROW : TokenType::MINUS);
+        case '-': if (match('>')) return make_token(TokenType::ARROW); return make_token(match('=') ? TokenType::MINUS_EQUAL : TokenType::MINUS);
         case '!': return make_token(match('=') ? TokenType::BANG_EQUAL : TokenType::UNKNOWN);
         case '<': return make_token(match('=') ? TokenType::LESS_EQUAL : TokenType::LESS); case '>': return make_token(match('=') ? TokenType::GREATER_EQUAL : TokenType::GREATER);
         case '"': case '\'': return string(c);
@@ -73,6 +74,11 @@ Token Tokenizer::make_token(TokenType type, const std::string& msg) {
 Token Tokenizer::identifier() {
     while (isalnum(peek()) || peek() == '_') advance();
     std::string text = source.substr(start, current - start);
+    if (text == "f" && (peek() == '"' || peek() == '\'')) { // f"..." interpolated string
+        Token token = string(advance());
+        if (token.type == TokenType::STRING) token.type = TokenType::FSTRING;
+        return token;
+    }
     auto it = keywords.find(text);
     return make_token(it != keywords.end() ? it->second : TokenType::IDENTIFIER);
 }
@@ -2,9 +2,11 @@
 #include <string>
 #include <map>
 #include <cctype>
+#include <cstdint>
 
-enum class TokenType {
-    DEC, STR, BIN, LN, ANY, DIM,
+// One byte, so AST nodes can carry an operator or type keyword inline.
+enum class TokenType : uint8_t {
+    DEC, STR, BIN, LN, ANY, DIM, F64,
     IF, THEN, ELSE, ELIF, ENDIF, END, WHILE, DO, FINALLY, ENDWHILE, FN, ENDFN, RETURN, SAY, ASK,
     FIN,
     TRY, CATCH, ENDTRY, RAISE,
@@ -12,7 +14,7 @@ enum class TokenType {
     INS, CONTAINS, ENDINS, STRUCT, IN,
     USING, AS, REQUIRE, EXPOSE,
     LOOP, FOR, TIMES, UNTIL, ENDLOOP, BREAK, CONTINUE,
-    IDENTIFIER, NUMBER, STRING, HEX_LITERAL,
+    IDENTIFIER, NUMBER, STRING, FSTRING, HEX_LITERAL,
     EQUAL, EQUAL_EQUAL, BANG_EQUAL, LESS, LESS_EQUAL, GREATER, GREATER_EQUAL, ARROW,
     PLUS, MINUS, STAR, SLASH, LPAREN, RPAREN, COMMA, CARET, MODULO,
     PLUS_EQUAL, MINUS_EQUAL, STAR_EQUAL, SLASH_EQUAL, CARET_EQUAL, MODULO_EQUAL,
@@ -28,8 +30,11 @@ struct Token { TokenType type; std::string lexeme; int line; };
 
 class Tokenizer {
 public:
-    Tokenizer(const std::string& source);
+    Tokenizer(const std::string& source, int first_line = 1);
     Token next_token();
+    // Source offset where the most recently returned token starts.
+    size_t token_start() const { return start; }
+    std::string text(size_t from, size_t to) const { return source.substr(from, to - from); }
 private:
     const std::string& source;
     size_t start, current;
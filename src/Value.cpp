@@ -2,9 +2,12 @@
 #include "Ast.hpp"
 #include <iomanip>
 #include <cmath>
+#include <cstring>
+#include <cstdlib>
 #include <algorithm>
 #include "msg_cn.hpp"
 #include "msgs.hpp"
+#include "StringOps.hpp"
 
 // NullValue
 std::string NullValue::repr() const {
@@ -52,11 +55,12 @@ SliceParams calculate_slice_indices(long long start, long long stop, long long s
 bool is_type_compatible(TokenType expected_type, const ValuePtr& value) {
     switch (expected_type) {
         case TokenType::ANY: return true;
-        case TokenType::DEC: return dynamic_cast<NumberValue*>(value.get()) != nullptr;
+        case TokenType::DEC: return dynamic_cast<NumberValue*>(value.get()) != nullptr || dynamic_cast<RationalValue*>(value.get()) != nullptr;
         case TokenType::STR: return dynamic_cast<StringValue*>(value.get()) != nullptr;
         case TokenType::BIN: return dynamic_cast<BinaryValue*>(value.get()) != nullptr;
         case TokenType::LN: return dynamic_cast<LnValue*>(value.get()) != nullptr;
         case TokenType::DIM: return dynamic_cast<DimValue*>(value.get()) != nullptr;
+        case TokenType::F64: return dynamic_cast<F64Value*>(value.get()) != nullptr;
         default: return true;
     }
 }
@@ -68,9 +72,69 @@ std::string token_type_to_string(TokenType type) {
         case TokenType::BIN: return "bin";
         case TokenType::LN: return "ln";
         case TokenType::DIM: return "dim";
+        case TokenType::F64: return "f64";
         default: return "unknown";
     }
 }
+std::string value_type_to_string(const ValuePtr& value) {
+    if (dynamic_cast<NumberValue*>(value.get())) return "dec";
+    if (dynamic_cast<RationalValue*>(value.get())) return "dec";
+    if (dynamic_cast<StringValue*>(value.get())) return "str";
+    if (dynamic_cast<BinaryValue*>(value.get())) return "bin";
+    if (dynamic_cast<LnValue*>(value.get())) return "ln";
+    if (dynamic_cast<DimValue*>(value.get())) return "dim";
+    if (dynamic_cast<F64Value*>(value.get())) return "f64";
+    return "unknown";
+}
+ValuePtr promote_to_declared(TokenType expected_type, const ValuePtr& value) {
+    if (expected_type == TokenType::F64) {
+        if (auto num = dynamic_cast<NumberValue*>(value.get())) return std::make_shared<F64Value>(num->value.toDouble());
+        if (auto rat = dynamic_cast<RationalValue*>(value.get())) return std::make_shared<F64Value>(rat->value.toBigNumber().toDouble());
+    }
+    return value;
+}
+ValuePtr make_exact(const Rational& r) {
+    if (r.isInteger()) return std::make_shared<NumberValue>(r.toBigNumber());
+    return std::make_shared<RationalValue>(r);
+}
+
+// --- f64 conversions ---
+// Fewest significant digits (1..17) that round-trip through strtod.
+static int shortest_f64_digits(double v, char* buf, size_t size) {
+    int p = 1;
+    for (; p < 17; ++p) {
+        snprintf(buf, size, "%.*e", p - 1, v);
+        if (strtod(buf, nullptr) == v) return p;
+    }
+    snprintf(buf, size, "%.*e", p - 1, v);
+    return p;
+}
+std::string f64_to_string(double v) {
+    if (std::isnan(v)) return "nan";
+    if (std::isinf(v)) return v < 0 ? "-inf" : "inf";
+    char buf[40];
+    int p = shortest_f64_digits(v, buf, sizeof buf);
+    int exp = atoi(strchr(buf, 'e') + 1);
+    if (exp < -4 || exp >= 16) return buf;
+    snprintf(buf, sizeof buf, "%.*f", std::max(0, p - 1 - exp), v);
+    std::string s = buf;
+    if (s.find('.') == std::string::npos) s += ".0";
+    return s;
+}
+BigNumber f64_to_bignumber(double v) {
+    if (!std::isfinite(v)) throw std::runtime_error("Cannot convert '" + f64_to_string(v) + "' to dec.");
+    char buf[40];
+    shortest_f64_digits(v, buf, sizeof buf);
+    // buf is "[-]d.ddde[+-]xx"; rebuild it as plain positional digits.
+    std::string mantissa(buf, strchr(buf, 'e')), digits;
+    bool negative = mantissa[0] == '-';
+    for (char c : mantissa) if (isdigit(c)) digits += c;
+    int point = atoi(strchr(buf, 'e') + 1) + 1; // digits before the decimal point
+    if (point <= 0) digits = "0." + std::string(-point, '0') + digits;
+    else if (point >= (int)digits.size()) digits += std::string(point - digits.size(), '0');
+    else digits.insert(point, ".");
+    return BigNumber(negative ? "-" + digits : digits);
+}
 
 // --- Default Value implementations ---
 ValuePtr Value::add(const Value&) const { throw std::runtime_error(msg(Msg::ADD_TYPE)); }
@@ -89,16 +153,109 @@ void Value::setSlice(const ValuePtr&, const ValuePtr&, const ValuePtr&, ValuePtr
 // NumberValue
 ValuePtr NumberValue::add(const Value& other) const {
     if (const NumberValue* o = dynamic_cast<const NumberValue*>(&other)) return std::make_shared<NumberValue>(this->value + o->value);
+    if (dynamic_cast<const F64Value*>(&other)) return F64Value(this->value.toDouble()).add(other);
+    if (dynamic_cast<const RationalValue*>(&other)) return RationalValue(Rational(this->value)).add(other);
     if (const BinaryValue* o = dynamic_cast<const BinaryValue*>(&other)) return std::make_shared<NumberValue>(this->value + o->toBigNumber());
     return std::make_shared<StringValue>(this->toString() + other.toString());
 }
-ValuePtr NumberValue::subtract(const Value& other) const { if (const NumberValue* o = dynamic_cast<const NumberValue*>(&other)) return std::make_shared<NumberValue>(this->value - o->value); return Value::subtract(other); }
-ValuePtr NumberValue::multiply(const Value& other) const { if (const NumberValue* o = dynamic_cast<const NumberValue*>(&other)) return std::make_shared<NumberValue>(this->value * o->value); return Value::multiply(other); }
-ValuePtr NumberValue::divide(const Value& other) const { if (const NumberValue* o = dynamic_cast<const NumberValue*>(&other)) return std::make_shared<NumberValue>(this->value / o->value); return Value::divide(other); }
-ValuePtr NumberValue::power(const Value& other) const { if (const NumberValue* o = dynamic_cast<const NumberValue*>(&other)) return std::make_shared<NumberValue>(this->value ^ o->value); return Value::power(other); }
-ValuePtr NumberValue::modulo(const Value& other) const { if (const NumberValue* o = dynamic_cast<const NumberValue*>(&other)) return std::make_shared<NumberValue>(this->value % o->value); return Value::modulo(other); }
-bool NumberValue::isEqualTo(const Value& other) const { if (const NumberValue* o = dynamic_cast<const NumberValue*>(&other)) return this->value == o->value; if (const BinaryValue* o = dynamic_cast<const BinaryValue*>(&other)) return this->value == o->toBigNumber(); return false; }
-bool NumberValue::isLessThan(const Value& other) const { if (const NumberValue* o = dynamic_cast<const NumberValue*>(&other)) return this->value < o->value; return Value::isLessThan(other); }
+ValuePtr NumberValue::subtract(const Value& other) const { if (const NumberValue* o = dynamic_cast<const NumberValue*>(&other)) return std::make_shared<NumberValue>(this->value - o->value); if (dynamic_cast<const F64Value*>(&other)) return F64Value(this->value.toDouble()).subtract(other); if (dynamic_cast<const RationalValue*>(&other)) return RationalValue(Rational(this->value)).subtract(other); return Value::subtract(other); }
+ValuePtr NumberValue::multiply(const Value& other) const { if (const NumberValue* o = dynamic_cast<const NumberValue*>(&other)) return std::make_shared<NumberValue>(this->value * o->value); if (dynamic_cast<const F64Value*>(&other)) return F64Value(this->value.toDouble()).multiply(other); if (dynamic_cast<const RationalValue*>(&other)) return RationalValue(Rational(this->value)).multiply(other); return Value::multiply(other); }
+ValuePtr NumberValue::divide(const Value& other) const {
+    if (const NumberValue* o = dynamic_cast<const NumberValue*>(&other)) {
+        if (Rational::exact_mode()) return make_exact(Rational::divide(this->value, o->value));
+        return std::make_shared<NumberValue>(this->value / o->value);
+    }
+    if (dynamic_cast<const RationalValue*>(&other)) return RationalValue(Rational(this->value)).divide(other);
+    if (dynamic_cast<const F64Value*>(&other)) return F64Value(this->value.toDouble()).divide(other);
+    return Value::divide(other);
+}
+ValuePtr NumberValue::power(const Value& other) const { if (const NumberValue* o = dynamic_cast<const NumberValue*>(&other)) return std::make_shared<NumberValue>(this->value ^ o->value); if (const RationalValue* o = dynamic_cast<const RationalValue*>(&other)) return std::make_shared<NumberValue>(this->value ^ o->value.toBigNumber()); if (dynamic_cast<const F64Value*>(&other)) return F64Value(this->value.toDouble()).power(other); return Value::power(other); }
+ValuePtr NumberValue::modulo(const Value& other) const { if (const NumberValue* o = dynamic_cast<const NumberValue*>(&other)) return std::make_shared<NumberValue>(this->value % o->value); if (dynamic_cast<const RationalValue*>(&other)) return RationalValue(Rational(this->value)).modulo(other); if (dynamic_cast<const F64Value*>(&other)) return F64Value(this->value.toDouble()).modulo(other); return Value::modulo(other); }
+bool NumberValue::isEqualTo(const Value& other) const { if (const NumberValue* o = dynamic_cast<const NumberValue*>(&other)) return this->value == o->value; if (const F64Value* o = dynamic_cast<const F64Value*>(&other)) return this->value.toDouble() == o->value; if (const RationalValue* o = dynamic_cast<const RationalValue*>(&other)) return o->isEqualTo(*this); if (const BinaryValue* o = dynamic_cast<const BinaryValue*>(&other)) return this->value == o->toBigNumber(); return false; }
+bool NumberValue::isLessThan(const Value& other) const { if (const NumberValue* o = dynamic_cast<const NumberValue*>(&other)) return this->value < o->value; if (const F64Value* o = dynamic_cast<const F64Value*>(&other)) return this->value.toDouble() < o->value; if (const RationalValue* o = dynamic_cast<const RationalValue*>(&other)) return Rational(this->value).compare(o->value) < 0; return Value::isLessThan(other); }
+bool NumberValue::isLessEqual(const Value& other) const { if (const F64Value* o = dynamic_cast<const F64Value*>(&other)) return this->value.toDouble() <= o->value; return Value::isLessEqual(other); }
+
+// RationalValue
+// Exact value of a dec operand; plain decs are converted into `scratch`.
+static const Rational* rational_operand(const Value& v, Rational& scratch) {
+    if (const RationalValue* r = dynamic_cast<const RationalValue*>(&v)) return &r->value;
+    if (const NumberValue* n = dynamic_cast<const NumberValue*>(&v)) { scratch = Rational(n->value); return &scratch; }
+    return nullptr;
+}
+ValuePtr RationalValue::add(const Value& other) const {
+    Rational scratch;
+    if (const Rational* o = rational_operand(other, scratch)) return make_exact(value + *o);
+    if (dynamic_cast<const F64Value*>(&other)) return F64Value(value.toBigNumber().toDouble()).add(other);
+    return std::make_shared<StringValue>(this->toString() + other.toString());
+}
+ValuePtr RationalValue::subtract(const Value& other) const {
+    Rational scratch;
+    if (const Rational* o = rational_operand(other, scratch)) return make_exact(value - *o);
+    if (dynamic_cast<const F64Value*>(&other)) return F64Value(value.toBigNumber().toDouble()).subtract(other);
+    return Value::subtract(other);
+}
+ValuePtr RationalValue::multiply(const Value& other) const {
+    Rational scratch;
+    if (const Rational* o = rational_operand(other, scratch)) return make_exact(value * *o);
+    if (dynamic_cast<const F64Value*>(&other)) return F64Value(value.toBigNumber().toDouble()).multiply(other);
+    return Value::multiply(other);
+}
+ValuePtr RationalValue::divide(const Value& other) const {
+    Rational scratch;
+    if (const Rational* o = rational_operand(other, scratch)) return make_exact(value / *o);
+    if (dynamic_cast<const F64Value*>(&other)) return F64Value(value.toBigNumber().toDouble()).divide(other);
+    return Value::divide(other);
+}
+ValuePtr RationalValue::modulo(const Value& other) const {
+    Rational scratch;
+    if (const Rational* o = rational_operand(other, scratch)) return make_exact(value % *o);
+    if (dynamic_cast<const F64Value*>(&other)) return F64Value(value.toBigNumber().toDouble()).modulo(other);
+    return Value::modulo(other);
+}
+ValuePtr RationalValue::power(const Value& other) const {
+    if (const NumberValue* o = dynamic_cast<const NumberValue*>(&other)) {
+        if (o->value.isInteger()) return make_exact(value.pow(o->value.toLongLong()));
+    }
+    return NumberValue(value.toBigNumber()).power(other);
+}
+bool RationalValue::isEqualTo(const Value& other) const {
+    Rational scratch;
+    if (const Rational* o = rational_operand(other, scratch)) return value.compare(*o) == 0;
+    if (const F64Value* f = dynamic_cast<const F64Value*>(&other)) return value.toBigNumber().toDouble() == f->value;
+    return false;
+}
+bool RationalValue::isLessThan(const Value& other) const {
+    Rational scratch;
+    if (const Rational* o = rational_operand(other, scratch)) return value.compare(*o) < 0;
+    if (const F64Value* f = dynamic_cast<const F64Value*>(&other)) return value.toBigNumber().toDouble() < f->value;
+    return Value::isLessThan(other);
+}
+bool RationalValue::isLessEqual(const Value& other) const {
+    if (const F64Value* f = dynamic_cast<const F64Value*>(&other)) return value.toBigNumber().toDouble() <= f->value;
+    return Value::isLessEqual(other);
+}
+
+// F64Value
+static bool f64_operand(const Value& v, double& out) {
+    if (const F64Value* f = dynamic_cast<const F64Value*>(&v)) { out = f->value; return true; }
+    if (const NumberValue* n = dynamic_cast<const NumberValue*>(&v)) { out = n->value.toDouble(); return true; }
+    if (const RationalValue* r = dynamic_cast<const RationalValue*>(&v)) { out = r->value.toBigNumber().toDouble(); return true; }
+    return false;
+}
+std::string F64Value::toString() const { return f64_to_string(value); }
+ValuePtr F64Value::add(const Value& other) const {
+    double o;
+    if (f64_operand(other, o)) return std::make_shared<F64Value>(value + o);
+    return std::make_shared<StringValue>(this->toString() + other.toString());
+}
+ValuePtr F64Value::subtract(const Value& other) const { double o; if (f64_operand(other, o)) return std::make_shared<F64Value>(value - o); return Value::subtract(other); }
+ValuePtr F64Value::multiply(const Value& other) const { double o; if (f64_operand(other, o)) return std::make_shared<F64Value>(value * o); return Value::multiply(other); }
+ValuePtr F64Value::divide(const Value& other) const { double o; if (f64_operand(other, o)) return std::make_shared<F64Value>(value / o); return Value::divide(other); }
+ValuePtr F64Value::power(const Value& other) const { double o; if (f64_operand(other, o)) return std::make_shared<F64Value>(std::pow(value, o)); return Value::power(other); }
+ValuePtr F64Value::modulo(const Value& other) const { double o; if (f64_operand(other, o)) return std::make_shared<F64Value>(std::fmod(value, o)); return Value::modulo(other); }
+bool F64Value::isEqualTo(const Value& other) const { double o; return f64_operand(other, o) && value == o; }
+bool F64Value::isLessThan(const Value& other) const { double o; if (f64_operand(other, o)) return value < o; return Value::isLessThan(other); }
+bool F64Value::isLessEqual(const Value& other) const { double o; if (f64_operand(other, o)) return value <= o; return Value::isLessEqual(other); }
 
 // BinaryValue
 BinaryValue::BinaryValue(const std::string& hex_str) {
@@ -123,13 +280,7 @@ bool BinaryValue::isTruthy() const {
     return false;
 }
 BigNumber BinaryValue::toBigNumber() const {
-    BigNumber result(0);
-    BigNumber power_of_256(1);
-    for (auto it = value.rbegin(); it != value.rend(); ++it) {
-        result = result + BigNumber((long long)*it) * power_of_256;
-        power_of_256 = power_of_256 * BigNumber(256);
-    }
-    return result;
+    return BigNumber::fromBytes(value);
 }
 ValuePtr BinaryValue::add(const Value& other) const {
     if (const NumberValue* o = dynamic_cast<const NumberValue*>(&other)) return std::make_shared<NumberValue>(this->toBigNumber() + o->value);
@@ -150,17 +301,94 @@ std::string StringValue::repr() const {
     ss << "'" << value << "'";
     return ss.str();
 }
+void StringValue::index() const {
+    if (indexed_size == value.size()) return;
+    if (indexed_size > value.size()) { indexed_size = code_points = 0; ascii = true; crumbs.clear(); }
+    const char* p = value.data();
+    size_t n = value.size(), i = indexed_size;
+    if (ascii && StringOps::is_ascii(p + i, n - i)) {
+        code_points += n - i;
+        indexed_size = n;
+        return;
+    }
+    if (ascii) { // First non-ASCII byte: lay crumbs over the ASCII prefix
+        ascii = false;
+        for (size_t cp = 0; cp < code_points; cp += CRUMB_STRIDE) crumbs.push_back(cp);
+    }
+    while (i < n) {
+        // Whole 16-byte blocks that end before the next crumb are only counted.
+        size_t next_crumb = crumbs.size() * CRUMB_STRIDE;
+        if (n - i >= 16) {
+            size_t block = StringOps::count_code_points(p + i, 16);
+            if (code_points + block <= next_crumb) {
+                code_points += block;
+                i += 16;
+                continue;
+            }
+        }
+        if (StringOps::starts_code_point(p[i])) {
+            if (code_points == next_crumb) crumbs.push_back(i);
+            ++code_points;
+        }
+        ++i;
+    }
+    indexed_size = n;
+}
+
+size_t StringValue::offset(size_t i) const {
+    index();
+    if (ascii) return i;
+    if (i >= code_points) return value.size();
+    if (i == 0) return 0; // Stray continuation bytes ahead of code point 0 belong to it
+    size_t byte = crumbs[i / CRUMB_STRIDE];
+    for (size_t left = i % CRUMB_STRIDE; left; --left) {
+        do ++byte; while (!StringOps::starts_code_point(value[byte]));
+    }
+    return byte;
+}
+
+size_t StringValue::position(size_t byte_offset) const {
+    index();
+    if (ascii || byte_offset >= value.size()) return ascii ? byte_offset : code_points;
+    // As in offset(), bytes ahead of the first code point belong to it.
+    if (crumbs.empty() || byte_offset < crumbs[0]) return 0;
+    size_t crumb = std::upper_bound(crumbs.begin(), crumbs.end(), byte_offset) - crumbs.begin() - 1;
+    size_t cp = crumb * CRUMB_STRIDE;
+    for (size_t byte = crumbs[crumb] + 1; byte <= byte_offset; ++byte) cp += StringOps::starts_code_point(value[byte]);
+    return cp;
+}
+
+ValuePtr StringValue::getSubscript(const Value& index_val) const {
+    const NumberValue* num_val = dynamic_cast<const NumberValue*>(&index_val);
+    long long i;
+    if (!num_val || !num_val->value.toSmallInt(i)) throw std::runtime_error(msg(Msg::STR_IDX_NUM));
+    long long len = length();
+    if (i < 0) i += len;
+    if (i < 0 || i >= len) throw std::runtime_error(msg(Msg::STR_IDX_OOB));
+    size_t begin = offset(i);
+    return std::make_shared<StringValue>(value.substr(begin, offset(i + 1) - begin));
+}
+
 ValuePtr StringValue::getSlice(const ValuePtr& start_val, const ValuePtr& end_val, const ValuePtr& step_val) const {
-    long long len = this->value.length();
+    long long len = length();
     long long step = value_to_long(step_val, 1);
     long long start = value_to_long(start_val, (step > 0) ? 0 : len - 1);
     long long end = value_to_long(end_val, (step > 0) ? len : -1);
     SliceParams params = calculate_slice_indices(start, end, step, len);
-    std::string result_str = "";
+    if (params.step == 1) {
+        if (params.stop <= params.start) return std::make_shared<StringValue>("");
+        size_t begin = offset(params.start);
+        return std::make_shared<StringValue>(value.substr(begin, offset(params.stop) - begin));
+    }
+    std::string result_str;
+    auto append = [&](long long i) {
+        size_t begin = offset(i);
+        result_str.append(value, begin, offset(i + 1) - begin);
+    };
     if (params.step > 0) {
-        for (long long i = params.start; i < params.stop; i += params.step) result_str += this->value[i];
+        for (long long i = params.start; i < params.stop; i += params.step) append(i);
     } else {
-        for (long long i = params.start; i > params.stop; i += params.step) result_str += this->value[i];
+        for (long long i = params.start; i > params.stop; i += params.step) append(i);
     }
     return std::make_shared<StringValue>(result_str);
 }
@@ -191,7 +419,7 @@ ValuePtr LnValue::multiply(const Value& other) const {
             if (times < 0) times = 0;
             std::vector<ValuePtr> new_elements;
             for (long long i = 0; i < times; ++i) {
-                for (const auto& elem : this->elements) new_elements.push_back(elem->clone());
+                for (const auto& elem : this->elements) new_elements.push_back(copy_value(elem));
             }
             return std::make_shared<LnValue>(new_elements);
         } catch (...) {
@@ -234,6 +462,13 @@ void LnValue::setSubscript(const Value& index, ValuePtr value) {
         throw std::runtime_error(msg(Msg::LN_IDX_INV));
     }
 }
+ValuePtr* LnValue::getSubscriptSlot(const Value& index) {
+    const NumberValue* num_val = dynamic_cast<const NumberValue*>(&index);
+    long long i, size = elements.size();
+    if (!num_val || !num_val->value.toSmallInt(i)) return nullptr;
+    if (i < 0) i += size;
+    return (i >= 0 && i < size) ? &elements[i] : nullptr;
+}
 ValuePtr LnValue::getSlice(const ValuePtr& start_val, const ValuePtr& end_val, const ValuePtr& step_val) const {
     long long len = this->elements.size();
     long long step = value_to_long(step_val, 1);
@@ -323,7 +558,7 @@ std::string DimValue::toString() const {
 ValuePtr DimValue::clone() const {
     std::map<std::string, ValuePtr> cloned;
     for (const auto& pair : dict) {
-        cloned[pair.first] = pair.second->clone();
+        cloned[pair.first] = copy_value(pair.second);
     }
     return std::make_shared<DimValue>(cloned);
 }
@@ -342,6 +577,13 @@ void DimValue::setSubscript(const Value& index, ValuePtr value) {
     }
     throw std::runtime_error(msg(Msg::DIM_KEY_TYPE));
 }
+ValuePtr* DimValue::getSubscriptSlot(const Value& index) {
+    if (const StringValue* s = dynamic_cast<const StringValue*>(&index)) {
+        auto it = dict.find(s->value);
+        if (it != dict.end()) return &it->second;
+    }
+    return nullptr;
+}
 bool DimValue::isEqualTo(const Value& other) const {
     const DimValue* o = dynamic_cast<const DimValue*>(&other);
     if (!o || dict.size() != o->dict.size()) return false;
@@ -9,6 +9,7 @@
 #include <algorithm>
 #include <cstdint>
 #include "BigNumber.hpp"
+#include "Rational.hpp"
 #include "Tokenizer.hpp"
 
 struct Function;
@@ -26,6 +27,9 @@ struct Value {
     virtual std::string repr() const = 0;
     virtual bool isTruthy() const = 0;
     virtual ValuePtr clone() const = 0;
+    // Scalars never change once built (in-place updates only touch values
+    // with a single owner), so copies may share them instead of cloning.
+    virtual bool isImmutable() const { return false; }
     virtual ValuePtr add(const Value& other) const;
     virtual ValuePtr subtract(const Value& other) const;
     virtual ValuePtr multiply(const Value& other) const;
@@ -34,18 +38,30 @@ struct Value {
     virtual ValuePtr modulo(const Value& other) const;
     virtual bool isEqualTo(const Value& other) const;
     virtual bool isLessThan(const Value& other) const;
+    // `<=`; overridden where it is not `!(other < this)`, as for f64 NaN.
+    virtual bool isLessEqual(const Value& other) const { return !other.isLessThan(*this); }
     virtual ValuePtr getSubscript(const Value& index) const;
     virtual void setSubscript(const Value& index, ValuePtr value);
+    // Storage slot behind `this[index]` if it already exists, else nullptr.
+    virtual ValuePtr* getSubscriptSlot(const Value&) { return nullptr; }
     virtual ValuePtr getSlice(const ValuePtr& start, const ValuePtr& end, const ValuePtr& step) const;
     virtual void setSlice(const ValuePtr& start, const ValuePtr& end, const ValuePtr& step, ValuePtr value);
 };
 
+// Value-semantics copy: immutable values are shared, containers deep-copied.
+// ln, dim and instances are copied eagerly; they are not copy-on-write,
+// since their contents are mutated directly in many places.
+inline ValuePtr copy_value(const ValuePtr& v) { return v->isImmutable() ? v : v->clone(); }
+
 class NullValue : public Value {
 public:
     std::string toString() const override { return "null"; }
     std::string repr() const override;
     bool isTruthy() const override { return false; }
-    ValuePtr clone() const override { return std::make_shared<NullValue>(); }
+    ValuePtr clone() const override { return instance(); }
+    bool isImmutable() const override { return true; }
+    // Shared null for hot paths that would otherwise allocate one per use.
+    static const ValuePtr& instance() { static const ValuePtr null_value = std::make_shared<NullValue>(); return null_value; }
     bool isEqualTo(const Value& other) const override;
 };
 
@@ -57,6 +73,51 @@ public:
     std::string repr() const override { return value.toString(); }
     bool isTruthy() const override { return value != BigNumber(0); }
     ValuePtr clone() const override { return std::make_shared<NumberValue>(value); }
+    bool isImmutable() const override { return true; }
+    ValuePtr add(const Value& other) const override;
+    ValuePtr subtract(const Value& other) const override;
+    ValuePtr multiply(const Value& other) const override;
+    ValuePtr divide(const Value& other) const override;
+    ValuePtr power(const Value& other) const override;
+    ValuePtr modulo(const Value& other) const override;
+    bool isEqualTo(const Value& other) const override;
+    bool isLessThan(const Value& other) const override;
+    bool isLessEqual(const Value& other) const override;
+};
+
+// Exact quotient produced by `/` while exact_mode is on. It type-checks as a
+// dec and is only turned into digits when printed or converted.
+class RationalValue : public Value {
+public:
+    Rational value;
+    RationalValue(const Rational& r) : value(r) {}
+    std::string toString() const override { return value.toString(); }
+    std::string repr() const override { return value.toString(); }
+    bool isTruthy() const override { return !value.isZero(); }
+    ValuePtr clone() const override { return std::make_shared<RationalValue>(value); }
+    bool isImmutable() const override { return true; }
+    ValuePtr add(const Value& other) const override;
+    ValuePtr subtract(const Value& other) const override;
+    ValuePtr multiply(const Value& other) const override;
+    ValuePtr divide(const Value& other) const override;
+    ValuePtr power(const Value& other) const override;
+    ValuePtr modulo(const Value& other) const override;
+    bool isEqualTo(const Value& other) const override;
+    bool isLessThan(const Value& other) const override;
+    bool isLessEqual(const Value& other) const override;
+};
+
+// Hardware double for throughput-bound code. Mixing it with dec promotes the
+// dec operand, so the result of any dec/f64 arithmetic is f64.
+class F64Value : public Value {
+public:
+    double value;
+    F64Value(double v) : value(v) {}
+    std::string toString() const override;
+    std::string repr() const override { return toString(); }
+    bool isTruthy() const override { return value != 0; }
+    ValuePtr clone() const override { return std::make_shared<F64Value>(value); }
+    bool isImmutable() const override { return true; }
     ValuePtr add(const Value& other) const override;
     ValuePtr subtract(const Value& other) const override;
     ValuePtr multiply(const Value& other) const override;
@@ -65,6 +126,7 @@ public:
     ValuePtr modulo(const Value& other) const override;
     bool isEqualTo(const Value& other) const override;
     bool isLessThan(const Value& other) const override;
+    bool isLessEqual(const Value& other) const override;
 };
 
 class BinaryValue : public Value {
@@ -76,23 +138,47 @@ public:
     std::string repr() const override { return toString(); }
     bool isTruthy() const override;
     ValuePtr clone() const override { return std::make_shared<BinaryValue>(value); }
+    bool isImmutable() const override { return true; }
     ValuePtr add(const Value& other) const override;
     bool isEqualTo(const Value& other) const override;
     BigNumber toBigNumber() const;
 };
 
+// Strings are indexed, sliced and measured in code points. An ASCII string
+// maps them straight to bytes; otherwise a breadcrumb index, built on first
+// use, holds the byte offset of every CRUMB_STRIDE-th code point, so finding
+// any code point scans at most one stride.
 class StringValue : public Value {
 public:
+    static const size_t CRUMB_STRIDE = 64;
     std::string value;
     StringValue(const std::string& s) : value(s) {}
     std::string toString() const override { return value; }
     std::string repr() const override;
     bool isTruthy() const override { return !value.empty(); }
     ValuePtr clone() const override { return std::make_shared<StringValue>(value); }
+    bool isImmutable() const override { return true; }
     ValuePtr add(const Value& other) const override;
     bool isEqualTo(const Value& other) const override;
     bool isLessThan(const Value& other) const override;
+    ValuePtr getSubscript(const Value& index) const override;
     ValuePtr getSlice(const ValuePtr& start, const ValuePtr& end, const ValuePtr& step) const override;
+
+    size_t length() const { index(); return code_points; }
+    // Byte offset of code point i, for 0 <= i <= length().
+    size_t offset(size_t i) const;
+    // Code point that the byte at `byte_offset` belongs to.
+    size_t position(size_t byte_offset) const;
+
+private:
+    // The index covers value[0, indexed_size). `value` only changes by
+    // appending (see update_in_place), so a longer value extends the index
+    // from where it stopped instead of rebuilding it.
+    mutable size_t indexed_size = 0;
+    mutable size_t code_points = 0;
+    mutable bool ascii = true;
+    mutable std::vector<size_t> crumbs;
+    void index() const;
 };
 
 class LnValue : public Value {
@@ -105,7 +191,7 @@ public:
     ValuePtr clone() const override {
         std::vector<ValuePtr> cloned;
         cloned.reserve(elements.size());
-        for (const auto& elem : elements) cloned.push_back(elem->clone());
+        for (const auto& elem : elements) cloned.push_back(copy_value(elem));
         return std::make_shared<LnValue>(cloned);
     }
     ValuePtr add(const Value& other) const override;
@@ -113,6 +199,7 @@ public:
     bool isEqualTo(const Value& other) const override;
     ValuePtr getSubscript(const Value& index) const override;
     void setSubscript(const Value& index, ValuePtr value) override;
+    ValuePtr* getSubscriptSlot(const Value& index) override;
     ValuePtr getSlice(const ValuePtr& start, const ValuePtr& end, const ValuePtr& step) const override;
     void setSlice(const ValuePtr& start, const ValuePtr& end, const ValuePtr& step, ValuePtr value) override;
     // Stack/queue operations
@@ -131,6 +218,7 @@ public:
     ValuePtr clone() const override;
     ValuePtr getSubscript(const Value& index) const override;
     void setSubscript(const Value& index, ValuePtr value) override;
+    ValuePtr* getSubscriptSlot(const Value& index) override;
     bool isEqualTo(const Value& other) const override;
 };
 
@@ -142,6 +230,7 @@ public:
     std::string repr() const override;
     bool isTruthy() const override { return true; }
     ValuePtr clone() const override { return std::make_shared<FunctionValue>(value); }
+    bool isImmutable() const override { return true; }
 };
 
 class NativeFnValue : public Value {
@@ -154,6 +243,7 @@ public:
     std::string repr() const override { return toString(); }
     bool isTruthy() const override { return true; }
     ValuePtr clone() const override { return std::make_shared<NativeFnValue>(name, fn); }
+    bool isImmutable() const override { return true; }
     ValuePtr call(const std::vector<ValuePtr>& args) const { return fn(args); }
 };
 
@@ -166,6 +256,7 @@ public:
     std::string repr() const override;
     bool isTruthy() const override { return true; }
     ValuePtr clone() const override { return std::make_shared<BoundMethodValue>(instance, method); }
+    bool isImmutable() const override { return true; }
 };
 
 class ExceptionValue : public Value {
@@ -175,7 +266,7 @@ public:
     std::string toString() const override { return "<Exception: " + payload->toString() + ">"; }
     std::string repr() const override;
     bool isTruthy() const override { return true; }
-    ValuePtr clone() const override { return std::make_shared<ExceptionValue>(payload->clone()); }
+    ValuePtr clone() const override { return std::make_shared<ExceptionValue>(copy_value(payload)); }
     bool isEqualTo(const Value& other) const override;
 };
 
@@ -193,6 +284,16 @@ public:
 // Type checking helpers
 bool is_type_compatible(TokenType expected_type, const ValuePtr& value);
 std::string token_type_to_string(TokenType type);
+std::string value_type_to_string(const ValuePtr& value);
+// Integral fractions collapse back to a plain dec.
+ValuePtr make_exact(const Rational& r);
+
+// A dec stored where f64 is declared is widened; everything else passes through.
+ValuePtr promote_to_declared(TokenType expected_type, const ValuePtr& value);
+
+// Shortest decimal text that reads back as the same double.
+std::string f64_to_string(double v);
+BigNumber f64_to_bignumber(double v);
 
 // Slicing helpers
 long long value_to_long(const ValuePtr& val_ptr, long long default_val);
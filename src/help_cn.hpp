@@ -68,6 +68,472 @@ rt(number, n=2)
     rt(8, 3)    # 返回 2（立方根）
 )"},
 
+    {"divmod", R"(
+divmod(a, b)
+  一次求出整数除法的商和余数。
+
+  参数:
+    a - 被除数（整数）
+    b - 除数（整数，不能为 0）
+
+  返回值:
+    ln [商, 余数]；商向零取整，余数与 a 同号，与 a % b 一致
+
+  示例:
+    divmod(17, 5)     # 返回 [3, 2]
+    divmod(-17, 5)    # 返回 [-3, -2]
+)"},
+
+    {"sum", R"(
+sum(list)
+  求 ln 中所有数字之和。各元素先按最长的小数位对齐，
+  最后统一进位，百万级元素也只需几十毫秒。
+
+  参数:
+    list - 由数字组成的 ln
+
+  返回值:
+    元素之和，空 ln 返回 0
+
+  示例:
+    sum([1, 2.5, -3])    # 返回 0.5
+)"},
+
+    {"prod", R"(
+prod(list)
+  求 ln 中所有数字之积，按两两配对的方式逐层相乘。
+
+  参数:
+    list - 由数字组成的 ln
+
+  返回值:
+    元素之积，空 ln 返回 1
+
+  示例:
+    prod([2, 3, 4])    # 返回 24
+)"},
+
+    {"mean", R"(
+mean(list)
+  求 ln 中所有数字的平均值，即 sum(list) / len(list)。
+
+  参数:
+    list - 由数字组成的非空 ln
+
+  返回值:
+    平均值
+
+  示例:
+    mean([1, 2, 3, 6])    # 返回 3
+)"},
+
+    {"dot", R"(
+dot(a, b)
+  求两个等长 ln 的点积，即对应元素乘积之和。
+
+  参数:
+    a, b - 长度相同、由数字组成的 ln
+
+  返回值:
+    点积
+
+  示例:
+    dot([1, 2, 3], [4, 5, 6])    # 返回 32
+)"},
+
+    {"factorial", R"(
+factorial(n)
+  计算 n 的阶乘。整段乘积按二分方式相乘，factorial(100000) 也能在一秒内算完。
+
+  参数:
+    n - 非负整数，不超过 1000000
+
+  返回值:
+    n!，factorial(0) 为 1
+
+  示例:
+    factorial(20)    # 返回 2432902008176640000
+)"},
+
+    {"binomial", R"(
+binomial(n, k)
+  计算组合数 C(n, k)，即从 n 个元素中取 k 个的方法数。
+
+  参数:
+    n, k - 非负整数，min(k, n - k) 不超过 1000000
+
+  返回值:
+    组合数；k > n 时为 0
+
+  示例:
+    binomial(10, 3)    # 返回 120
+)"},
+
+    {"perm", R"(
+perm(n, k)
+  计算排列数 P(n, k) = n! / (n - k)!。
+
+  参数:
+    n, k - 非负整数，k 不超过 1000000
+
+  返回值:
+    排列数；k > n 时为 0
+
+  示例:
+    perm(10, 3)    # 返回 720
+)"},
+
+    {"fib", R"(
+fib(n)
+  用快速倍增法计算第 n 个斐波那契数，fib(0) = 0，fib(1) = 1。
+
+  参数:
+    n - 非负整数，不超过 50000000
+
+  返回值:
+    第 n 个斐波那契数
+
+  示例:
+    fib(100)    # 返回 354224848179261915075
+)"},
+
+    {"seed", R"(
+seed(n)
+  设置随机数种子。种子相同时，random、randint 等函数产生的序列完全一致。
+  未调用时以启动时间作为种子。
+
+  参数:
+    n - 整数种子
+
+  示例:
+    seed(42)
+)"},
+
+    {"random", R"(
+random()
+  返回 [0, 1) 内均匀分布的随机数（xoshiro256** 生成器）。
+
+  返回值:
+    f64 类型的随机数
+
+  示例:
+    f64 x = random()
+)"},
+
+    {"randint", R"(
+randint(a, b)
+  返回 [a, b] 内均匀分布的随机整数，两端都可能取到。上下界可以是任意大的整数。
+
+  参数:
+    a, b - 整数，且 a <= b
+
+  示例:
+    randint(1, 6)    # 掷骰子
+)"},
+
+    {"shuffle", R"(
+shuffle(list)
+  随机打乱 ln 的顺序，返回新 ln，原 ln 不变。
+
+  示例:
+    shuffle([1, 2, 3, 4])
+)"},
+
+    {"random_ln", R"(
+random_ln(n)
+random_ln(n, a, b)
+  一次生成 n 个随机数组成的 ln，比循环调用 random 快得多。
+
+  参数:
+    n - 元素个数
+    a, b - 可选，给出时生成 [a, b] 内的随机整数，否则生成 [0, 1) 内的 f64
+
+  示例:
+    random_ln(1000, 1, 6)
+)"},
+
+    {"random_bin", R"(
+random_bin(n)
+  生成 n 个随机字节组成的 bin。
+
+  示例:
+    random_bin(16)
+)"},
+
+    {"random_digits", R"(
+random_digits(n)
+  生成恰好 n 位（首位不为 0）的均匀随机整数，直接按内部存储格式构造。
+
+  示例:
+    random_digits(100)
+)"},
+
+    {"xxhash64", R"(
+xxhash64(data, seed)
+  计算 xxHash64 哈希。str 和 bin 直接按字节计算，其他值先转为字符串。
+
+  参数:
+    data - 要哈希的数据
+    seed - 可选，整数种子，默认为 0
+
+  返回值:
+    0 到 2^64-1 之间的整数
+
+  示例:
+    xxhash64("abc")    # 返回 4952883123889572249
+)"},
+
+    {"crc32", R"(
+crc32(data)
+  计算 CRC-32 校验值（与 zip、png 所用算法相同）。
+
+  参数:
+    data - str 或 bin
+
+  返回值:
+    0 到 2^32-1 之间的整数
+
+  示例:
+    crc32("The quick brown fox jumps over the lazy dog")    # 返回 1095738169
+)"},
+
+    {"sha256", R"(
+sha256(data)
+  计算 SHA-256 摘要。
+
+  参数:
+    data - str 或 bin
+
+  返回值:
+    32 字节的 bin
+
+  示例:
+    sha256("abc")    # 返回 0xba7816bf...f20015ad
+)"},
+
+    {"siphash", R"(
+siphash(data, key)
+  计算带密钥的 SipHash-2-4，适合防止恶意构造碰撞的场景。
+
+  参数:
+    data - str 或 bin
+    key - 整数，或 16 字节的 bin
+
+  返回值:
+    0 到 2^64-1 之间的整数
+)"},
+
+    {"structural_hash", R"(
+structural_hash(x)
+  按内容计算任意值的哈希，可用作缓存的键。ln 和 dim 递归计算各元素，
+  相等的值（如 1 和 1.0）哈希相同。
+
+  示例:
+    structural_hash([1, 2]) == structural_hash([1.0, 2])    # 返回 1
+)"},
+
+    {"memo", R"(
+memo(f, capacity)
+  为脚本函数开启结果缓存：以相同参数再次调用时直接返回缓存的结果，
+  递归调用也会命中。也可以用 fn memo 名称(...) 直接定义。
+
+  参数:
+    f - 脚本定义的函数
+    capacity - 可选，最多缓存的条目数，默认 65536；超出时淘汰最久未用的条目
+
+  返回值:
+    f 本身
+
+  示例:
+    memo(fib)
+    fib(200)
+)"},
+
+    {"memo_stats", R"(
+memo_stats(f)
+  查看函数的缓存统计。
+
+  返回值:
+    dim，包含 hits（命中）、misses（未命中）、size（条目数）、capacity（容量）
+
+  示例:
+    memo_stats(fib)["hits"]
+)"},
+
+    {"table", R"(
+table(S, n)
+  创建 struct S 的列式表。每个字段存成一列，dec 和 f64 字段直接存放数值，
+  不再为每一行分配实例。t[i] 返回可读写的行，for-in 逐行遍历，len(t) 为行数。
+
+  参数:
+    S - 用 struct 定义的类型
+    n - 可选，预先填入的默认行数
+
+  示例:
+    struct Point(dec x = 0, dec y = 0)
+    any t = table(Point, 100)
+    t[0].x = 5
+)"},
+
+    {"append", R"(
+append(t, v1, v2, ...)
+append(t, instance)
+  向表末尾追加一行。可以按字段顺序给出各字段的值（缺省的取默认值），
+  也可以给出一个同类型的实例。
+
+  示例:
+    append(t, 3, 4)
+)"},
+
+    {"column", R"(
+column(t, field)
+  把表的一列取出为 ln。
+
+  示例:
+    column(t, "x")
+)"},
+
+    {"sort_by", R"(
+sort_by(t, field, descending)
+  按某个字段排序，返回新表。直接比较列中的数值，不创建行对象。
+
+  参数:
+    t - 表
+    field - 字段名
+    descending - 可选，为 1 时降序
+
+  示例:
+    sort_by(t, "x")
+)"},
+
+    {"filter", R"(
+filter(x, fn)
+  保留使 fn 返回真值的元素。x 为 ln 时返回 ln，为表时返回由对应行组成的新表。
+
+  示例:
+    filter([1, 2, 3, 4], fn(dec v) -> v % 2 == 0)    # 返回 [2, 4]
+    filter(t, fn(any p) -> p.x > 0)
+)"},
+
+    {"format", R"(
+format(fmt, ...)
+  把参数依次填入 fmt 中的 {}，或按位置填入 {n}（从 0 开始），返回新字符串。
+  格式说明与 f-字符串相同：{:[[填充]对齐][0][宽度][.精度][f|s]}。
+
+  参数:
+    fmt - 格式字符串，{{ 和 }} 表示字面的花括号
+    ... - 要填入的值
+
+  示例:
+    format("{} + {} = {}", 1, 2, 3)    # 返回 "1 + 2 = 3"
+    format("{:>8.2}", 3.14159)         # 返回 "    3.14"
+    f"{name:<10}|"                     # f-字符串使用同样的格式说明
+)"},
+
+    {"find", R"(
+find(s, sub, start)
+  返回 sub 在 s 中第一次出现的位置（按字符计，从 0 开始），找不到返回 -1。
+
+  参数:
+    s - 字符串
+    sub - 要查找的子串
+    start - 可选，从该位置开始查找
+
+  示例:
+    find("hello world", "o")       # 返回 4
+    find("hello world", "o", 5)    # 返回 7
+)"},
+
+    {"rfind", R"(
+rfind(s, sub)
+  返回 sub 在 s 中最后一次出现的位置，找不到返回 -1。
+
+  示例:
+    rfind("hello world", "o")      # 返回 7
+)"},
+
+    {"count", R"(
+count(s, sub)
+  返回 sub 在 s 中不重叠出现的次数。sub 不能为空。
+
+  示例:
+    count("banana", "an")          # 返回 2
+)"},
+
+    {"split", R"(
+split(s, sep)
+  按分隔符把字符串拆分为 ln。省略 sep 时按连续空白拆分并丢弃空片段；
+  s 为空字符串时返回空 ln。
+
+  示例:
+    split("a,b,,c", ",")           # 返回 ['a', 'b', '', 'c']
+    split("  a  b ")               # 返回 ['a', 'b']
+)"},
+
+    {"join", R"(
+join(ln, sep)
+  用分隔符连接 ln 的元素，非字符串元素按 say() 的方式转换。省略 sep 时直接相连。
+
+  示例:
+    join(["a", "b", 3], "-")       # 返回 "a-b-3"
+)"},
+
+    {"replace", R"(
+replace(s, old, new)
+  把 s 中所有的 old 替换为 new，返回新字符串。old 不能为空。
+
+  示例:
+    replace("a-b-c", "-", "+")     # 返回 "a+b+c"
+)"},
+
+    {"starts_with", R"(
+starts_with(s, prefix)
+  s 以 prefix 开头时返回 1，否则返回 0。
+
+  示例:
+    starts_with("PyRite", "Py")    # 返回 1
+)"},
+
+    {"strip", R"(
+strip(s)
+  去除首尾的空白字符（空格、制表符、换行等）。
+
+  示例:
+    strip("  hi  ")                # 返回 "hi"
+)"},
+
+    {"upper", R"(
+upper(s)
+  把 ASCII 小写字母转为大写，其他字符不变。
+
+  示例:
+    upper("abc")                   # 返回 "ABC"
+)"},
+
+    {"lower", R"(
+lower(s)
+  把 ASCII 大写字母转为小写，其他字符不变。
+
+  示例:
+    lower("ABC")                   # 返回 "abc"
+)"},
+
+    {"exact_mode", R"(
+exact_mode(on)
+  开启或关闭精确分数模式。开启后 dec 相除得到约分后的分数，
+  打印或调用 approx 时才按精度展开为小数。
+
+  参数:
+    on - 可选，1 开启，0 关闭；省略时只查询
+
+  返回值:
+    调用前的设置（1 或 0）
+
+  示例:
+    exact_mode(1)
+    say(1 / 3 * 3)    # 输出 1
+)"},
+
     {"sort", R"(
 sort(list)
   对列表进行排序并返回新列表。
@@ -6,6 +6,7 @@
 #include <cctype>
 #include <map>
 #include "Interpreter.hpp"
+#include "Optimizer.hpp"
 #include "help_cn.hpp"
 #include "msg_cn.hpp"
 
@@ -49,7 +50,9 @@ void run_file(const char* filename, Interpreter& interpreter) {
     file.close();
     Parser parser(source_code);
     auto statements = parser.parse();
+    interpreter.keep_arena(parser.node_arena());
     if (parser.has_error()) { exit(1); }
+    Optimizer().run(statements);
     interpreter.interpret(statements);
 }
 
@@ -115,11 +118,10 @@ void run_repl(Interpreter& interpreter) {
         }
 
         if (is_simple_identifier(trimmed_line)) {
-            try {
-                ValuePtr val = interpreter.environment->get(trimmed_line);
+            if (ValuePtr val = interpreter.environment->try_get(trimmed_line)) {
                 std::cout << val->repr() << std::endl;
                 continue;
-            } catch (const RuntimeError&) {}
+            }
         }
 
         if (starts_with(trimmed_line, "run(") && ends_with(trimmed_line, ")")) {
@@ -153,6 +155,7 @@ void run_repl(Interpreter& interpreter) {
             }
             Parser parser(interpreter.repl_buffer);
             auto statements = parser.parse();
+            interpreter.keep_arena(parser.node_arena());
             if (!parser.has_error()) {
                 auto start_time = std::chrono::high_resolution_clock::now();
                 interpreter.start_time = start_time;
@@ -208,6 +211,7 @@ void run_repl(Interpreter& interpreter) {
             }
             Parser p(code_to_run);
             auto stmts = p.parse();
+            interpreter.keep_arena(p.node_arena());
             if (!p.has_error()) interpreter.interpret(stmts);
             if (is_temp_exec_only) {
                 interpreter.repl_buffer += "#" + code_to_run + "#\n";
@@ -1,5 +1,6 @@
 #pragma once
 #include "msgs.hpp"
+#include <vector>
 
 inline const char* msg(Msg id) {
     switch (id) {
@@ -56,6 +57,23 @@ inline const char* msg(Msg id) {
         case Msg::NATIVE_MINMAX_CMP: return "min/max 的参数必须是可比较的类型。";
         case Msg::NATIVE_TIMER: return "计时器函数不接受参数。";
         case Msg::NATIVE_LOG_POS: return "log() 的参数必须是正数。";
+        case Msg::NATIVE_MEAN_EMPTY: return "无法求空列表的平均值。";
+        case Msg::NATIVE_DOT_LEN: return "dot() 需要两个长度相同的列表。";
+        case Msg::NATIVE_COUNT: return "参数必须是非负整数。";
+        case Msg::NATIVE_RAND_RANGE: return "上下界必须是整数，且 a <= b。";
+        case Msg::NATIVE_SIP_KEY: return "siphash() 的密钥必须是整数或 16 字节的 bin。";
+        case Msg::NATIVE_MEMO_FN: return "参数必须是脚本定义的函数。";
+        case Msg::NATIVE_TOO_LARGE: return "参数过大。";
+        case Msg::TABLE_STRUCT: return "table() 需要一个 struct。";
+        case Msg::TABLE_ROW: return "表的行必须是该表对应 struct 的实例。";
+        case Msg::TABLE_TOO_MANY: return "给出的值多于表的字段数。";
+        case Msg::NATIVE_TABLE: return "参数必须是 table。";
+        case Msg::FORMAT_BRACE: return "格式字符串中的 '{' 或 '}' 不成对。";
+        case Msg::FORMAT_SPEC: return "无效的格式说明。";
+        case Msg::FORMAT_ARGS: return "格式字符串的参数不足。";
+        case Msg::NATIVE_EMPTY_PATTERN: return "分隔符或查找的字符串不能为空。";
+        case Msg::STR_IDX_NUM: return "str 索引必须是整数。";
+        case Msg::STR_IDX_OOB: return "str 索引超出范围。";
 
         case Msg::PARSE_PREFIX: return "[解析错误] 在 行 ";
         case Msg::PARSE_UNEXPECTED: return "意外的字符。";
@@ -168,3 +186,12 @@ inline std::string fmt3(Msg id, const std::string& a1, const std::string& a2, co
     }
     return a1 + a2 + a3;
 }
+
+// Renders a message from its structured arguments (see RuntimeError).
+inline std::string fmt_args(Msg id, const std::vector<std::string>& a) {
+    switch (id) {
+        case Msg::FIELD_TYPE: return std::string("字段 '") + a[0] + "' 类型不匹配。期望 " + a[1] + ", 得到 " + a[2] + "。";
+        case Msg::ARG_TYPE: return fmt3(id, a[0], a[1], a[2]) + "期望 " + a[3] + ", 得到 " + a[4] + "。";
+        default: return a.empty() ? std::string(msg(id)) : fmt(id, a[0]);
+    }
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include "msgs.hpp"
+#include <vector>
 
 inline const char* msg(Msg id) {
     switch (id) {
@@ -56,6 +57,23 @@ inline const char* msg(Msg id) {
         case Msg::NATIVE_MINMAX_CMP: return "min/max arguments must be comparable.";
         case Msg::NATIVE_TIMER: return "Timer function takes no arguments.";
         case Msg::NATIVE_LOG_POS: return "log() argument must be positive.";
+        case Msg::NATIVE_MEAN_EMPTY: return "Cannot take the mean of an empty list.";
+        case Msg::NATIVE_DOT_LEN: return "dot() requires two lists of the same length.";
+        case Msg::NATIVE_COUNT: return "Argument must be a non-negative integer.";
+        case Msg::NATIVE_RAND_RANGE: return "Bounds must be integers with a <= b.";
+        case Msg::NATIVE_SIP_KEY: return "siphash() key must be an integer or a 16-byte bin.";
+        case Msg::NATIVE_MEMO_FN: return "Argument must be a script function.";
+        case Msg::NATIVE_TOO_LARGE: return "Argument is too large.";
+        case Msg::TABLE_STRUCT: return "table() requires a struct.";
+        case Msg::TABLE_ROW: return "Table rows must be instances of the table's struct.";
+        case Msg::TABLE_TOO_MANY: return "More values than the table has fields.";
+        case Msg::NATIVE_TABLE: return "Argument must be a table.";
+        case Msg::FORMAT_BRACE: return "Unbalanced '{' or '}' in format string.";
+        case Msg::FORMAT_SPEC: return "Invalid format specifier.";
+        case Msg::FORMAT_ARGS: return "Not enough arguments for format string.";
+        case Msg::NATIVE_EMPTY_PATTERN: return "Separator or search string must not be empty.";
+        case Msg::STR_IDX_NUM: return "str index must be an integer.";
+        case Msg::STR_IDX_OOB: return "str index out of range.";
 
         case Msg::PARSE_PREFIX: return "[Parse Error] Line ";
         case Msg::PARSE_UNEXPECTED: return "Unexpected character.";
@@ -168,3 +186,12 @@ inline std::string fmt3(Msg id, const std::string& a1, const std::string& a2, co
     }
     return a1 + a2 + a3;
 }
+
+// Renders a message from its structured arguments (see RuntimeError).
+inline std::string fmt_args(Msg id, const std::vector<std::string>& a) {
+    switch (id) {
+        case Msg::FIELD_TYPE: return std::string("Field '") + a[0] + "' type mismatch. Expected " + a[1] + ", got " + a[2] + ".";
+        case Msg::ARG_TYPE: return fmt3(id, a[0], a[1], a[2]) + " Expected " + a[3] + ", got " + a[4] + ".";
+        default: return a.empty() ? std::string(msg(id)) : fmt(id, a[0]);
+    }
+}
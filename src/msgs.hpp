@@ -20,7 +20,10 @@ enum class Msg {
     // --- native fns ---
     NATIVE_ARGS, NATIVE_MIN_ARGS, NATIVE_NUM, NATIVE_LN, NATIVE_STR,
     NATIVE_RT, NATIVE_MINMAX_EMPTY, NATIVE_MINMAX_LIST, NATIVE_MINMAX_CMP,
-    NATIVE_TIMER, NATIVE_LOG_POS,
+    NATIVE_TIMER, NATIVE_LOG_POS, NATIVE_MEAN_EMPTY, NATIVE_DOT_LEN, NATIVE_COUNT, NATIVE_RAND_RANGE, NATIVE_SIP_KEY, NATIVE_MEMO_FN, NATIVE_TOO_LARGE,
+    TABLE_STRUCT, TABLE_ROW, TABLE_TOO_MANY, NATIVE_TABLE,
+    FORMAT_BRACE, FORMAT_SPEC, FORMAT_ARGS, NATIVE_EMPTY_PATTERN,
+    STR_IDX_NUM, STR_IDX_OOB,
 
     // --- parser ---
     PARSE_PREFIX, PARSE_UNEXPECTED, PARSE_UNTERM_STR, PARSE_EXPR,